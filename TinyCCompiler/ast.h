@@ -1,11 +1,11 @@
 #ifndef AST_H
 #define AST_H
 
-#include <memory>
 #include <string>
-#include <vector>
 
 #include "token.h"
+#include "string_interner.h"
+#include "ast_arena.h"
 
 struct StatementAST;
 struct BlockItemAST;
@@ -33,113 +33,130 @@ enum class BlockItemType {
 
 struct ExprAST {
 	ExpressionType type;
+	uint32_t offset; // Source offset of the variable in variable and assignment nodes
 
 	union {
 		struct {
 			TokenType unOp;
-			std::unique_ptr<ExprAST> expr;
+			ExprAST* expr;
 		} unary;
 
 		struct {
-			std::unique_ptr<ExprAST> left;
+			ExprAST* left;
 			TokenType binOp;
-			std::unique_ptr<ExprAST> right;
+			ExprAST* right;
 		} binary;
 
 		struct {
-			std::string varName;
-			std::unique_ptr<ExprAST> expr;
+			Symbol varName;
+			ExprAST* expr;
 		} varAssignment;
 
 		int32_t intVal;
-		std::string varName;
+		Symbol varName;
 	};
 
-	ExprAST(TokenType op, std::unique_ptr<ExprAST> _expr) : type(ExpressionType::EXPR_UNARY), unary{ op, std::move(_expr) } {};
-	ExprAST(std::unique_ptr<ExprAST> _left, TokenType op, std::unique_ptr<ExprAST> _right) : type(ExpressionType::EXPR_BINARY), binary{ std::move(_left), op, std::move(_right) } {};
-	ExprAST(std::string _name, std::unique_ptr<ExprAST> _expr) : type(ExpressionType::EXPR_ASSIGNMENT), varAssignment{ _name, std::move(_expr) } {};
-	ExprAST(int32_t _val) : type(ExpressionType::EXPR_INT), intVal(_val) {};
-	ExprAST(std::string name) : type(ExpressionType::EXPR_VARIABLE), varName(name) {};
-	~ExprAST() {};
+	ExprAST(TokenType op, ExprAST* _expr) : type(ExpressionType::EXPR_UNARY), offset(0), unary{ op, _expr } {};
+	ExprAST(ExprAST* _left, TokenType op, ExprAST* _right) : type(ExpressionType::EXPR_BINARY), offset(0), binary{ _left, op, _right } {};
+	ExprAST(Symbol _name, uint32_t _offset, ExprAST* _expr) : type(ExpressionType::EXPR_ASSIGNMENT), offset(_offset), varAssignment{ _name, _expr } {};
+	ExprAST(int32_t _val) : type(ExpressionType::EXPR_INT), offset(0), intVal(_val) {};
+	ExprAST(Symbol name, uint32_t _offset) : type(ExpressionType::EXPR_VARIABLE), offset(_offset), varName(name) {};
 };
 
 struct ConditionAST {
-	std::unique_ptr<ExprAST> expr;
-	std::unique_ptr<BlockAST> ifClause, elseClause;
+	ExprAST* expr;
+	BlockAST* ifClause;
+	BlockAST* elseClause;
 
-	ConditionAST(std::unique_ptr<ExprAST> _expr, std::unique_ptr<BlockAST> _if, std::unique_ptr<BlockAST> _else) : expr(std::move(_expr)), ifClause(std::move(_if)), elseClause(std::move(_else)) {};
+	ConditionAST(ExprAST* _expr, BlockAST* _if, BlockAST* _else) : expr(_expr), ifClause(_if), elseClause(_else) {};
 };
 
 struct DeclarationAST {
-	std::string varName;
-	std::unique_ptr<ExprAST> expr;
+	Symbol varName;
+	uint32_t offset;
+	ExprAST* expr;
 
-	DeclarationAST(std::string _varName) : varName(_varName), expr(nullptr) {};
-	DeclarationAST(std::string _varName, std::unique_ptr<ExprAST> _expr) : varName(_varName), expr(std::move(_expr)) {};
+	DeclarationAST(Symbol _varName, uint32_t _offset, ExprAST* _expr) : varName(_varName), offset(_offset), expr(_expr) {};
 };
 
 struct BlockItemAST {
 	BlockItemType type;
 
-	std::unique_ptr<DeclarationAST> declaration;
-	std::unique_ptr<StatementAST> statement;
-
-	BlockItemAST(std::unique_ptr<DeclarationAST> decl) : type(BlockItemType::DECLARATION), declaration(std::move(decl)) {};
-	BlockItemAST(std::unique_ptr<StatementAST> _statement) : type(BlockItemType::STATEMENT), statement(std::move(_statement)) {};
-	~BlockItemAST() {
-		if (type == BlockItemType::DECLARATION) {
-			declaration.reset();
-		}
-		if (type == BlockItemType::STATEMENT) {
-			statement.reset();
-		}
+	union {
+		DeclarationAST* declaration;
+		StatementAST* statement;
 	};
+
+	BlockItemAST(DeclarationAST* decl) : type(BlockItemType::DECLARATION), declaration(decl) {};
+	BlockItemAST(StatementAST* _statement) : type(BlockItemType::STATEMENT), statement(_statement) {};
 };
 
 struct StatementAST {
 	StatementType type;
 
 	union {
-		std::unique_ptr<ExprAST> expr;
-		std::unique_ptr<BlockAST> block;
-		std::unique_ptr<ConditionAST> condition;
+		ExprAST* expr;
+		BlockAST* block;
+		ConditionAST* condition;
 	};
 
-	StatementAST(StatementType _type, std::unique_ptr<ExprAST> _expr) : type(_type), expr(std::move(_expr)) {};
-	StatementAST(std::unique_ptr<BlockAST> _block) : type(StatementType::BLOCK), block(std::move(_block)) {};
-	StatementAST(std::unique_ptr<ConditionAST> _cond) : type(StatementType::CONDITION), condition(std::move(_cond)) {};
-
-	~StatementAST() {
-		if (type == StatementType::BLOCK) {
-			block.reset();
-		}
-		else if (type == StatementType::EXPRESSION_STATEMENT || type == StatementType::RETURN_STATEMENT) {
-			expr.reset();
-		}
-	}
+	StatementAST(StatementType _type, ExprAST* _expr) : type(_type), expr(_expr) {};
+	StatementAST(BlockAST* _block) : type(StatementType::BLOCK), block(_block) {};
+	StatementAST(ConditionAST* _cond) : type(StatementType::CONDITION), condition(_cond) {};
 };
 
 struct BlockAST {
-	std::vector<std::unique_ptr<BlockItemAST>> items;
+	ArenaSpan<BlockItemAST*> items;
 
-	BlockAST(std::vector<std::unique_ptr<BlockItemAST>>& _items) {
-		for (int i = 0; i < _items.size(); i++) {
-			items.push_back(std::move(_items[i]));
-		}
-	}
+	BlockAST(ArenaSpan<BlockItemAST*> _items) : items(_items) {};
 };
 
 struct FunctionAST  {
-	std::string name;
-	std::unique_ptr<BlockAST> block;
+	Symbol name;
+	uint32_t offset;
+	BlockAST* block;
 
-	FunctionAST(std::string _name, std::unique_ptr<BlockAST> _block) : name(_name), block(std::move(_block)) {};
+	FunctionAST(Symbol _name, uint32_t _offset, BlockAST* _block) : name(_name), offset(_offset), block(_block) {};
 };
 
+// All nodes live in the AstArena they were parsed into and die with it.
 struct ProgramAST
 {
-	std::unique_ptr<FunctionAST> function;
-	ProgramAST(std::unique_ptr<FunctionAST> _func) : function(std::move(_func)) {};
+	ArenaSpan<FunctionAST*> functions;
+	ProgramAST(ArenaSpan<FunctionAST*> _functions) : functions(_functions) {};
+};
+
+// Node factory used by the parser to build the pointer-linked tree in an arena.
+class ArenaAstBuilder {
+public:
+	typedef ProgramAST* Program;
+	typedef FunctionAST* Function;
+	typedef BlockAST* Block;
+	typedef BlockItemAST* BlockItem;
+	typedef DeclarationAST* Declaration;
+	typedef ConditionAST* Condition;
+	typedef StatementAST* Statement;
+	typedef ExprAST* Expr;
+
+	ArenaAstBuilder(AstArena& _arena) : arena(_arena) {};
+
+	ProgramAST* program(FunctionAST* const* first, FunctionAST* const* last) { return arena.make<ProgramAST>(arena.copy(first, last)); }
+	FunctionAST* function(Symbol name, uint32_t offset, BlockAST* block) { return arena.make<FunctionAST>(name, offset, block); }
+	BlockAST* block(BlockItemAST* const* first, BlockItemAST* const* last) { return arena.make<BlockAST>(arena.copy(first, last)); }
+	BlockItemAST* declarationItem(DeclarationAST* declaration) { return arena.make<BlockItemAST>(declaration); }
+	BlockItemAST* statementItem(StatementAST* statement) { return arena.make<BlockItemAST>(statement); }
+	DeclarationAST* declaration(Symbol name, uint32_t offset, ExprAST* expr) { return arena.make<DeclarationAST>(name, offset, expr); }
+	ConditionAST* condition(ExprAST* expr, BlockAST* ifClause, BlockAST* elseClause) { return arena.make<ConditionAST>(expr, ifClause, elseClause); }
+	StatementAST* statement(StatementType type, ExprAST* expr) { return arena.make<StatementAST>(type, expr); }
+	StatementAST* blockStatement(BlockAST* block) { return arena.make<StatementAST>(block); }
+	StatementAST* conditionStatement(ConditionAST* condition) { return arena.make<StatementAST>(condition); }
+	ExprAST* intLiteral(int32_t value) { return arena.make<ExprAST>(value); }
+	ExprAST* variable(Symbol name, uint32_t offset) { return arena.make<ExprAST>(name, offset); }
+	ExprAST* unary(TokenType op, ExprAST* expr) { return arena.make<ExprAST>(op, expr); }
+	ExprAST* binary(ExprAST* left, TokenType op, ExprAST* right) { return arena.make<ExprAST>(left, op, right); }
+	ExprAST* assignment(Symbol name, uint32_t offset, ExprAST* expr) { return arena.make<ExprAST>(name, offset, expr); }
+private:
+	AstArena& arena;
 };
 
 #endif
\ No newline at end of file
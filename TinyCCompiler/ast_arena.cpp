@@ -0,0 +1,38 @@
+#include "ast_arena.h"
+
+AstArena::AstArena() : blockIndex(0), blockUsed(0), usedBefore(0) {}
+
+void* AstArena::allocate(size_t size, size_t alignment) {
+	if (size > BLOCK_SIZE / 4) {
+		largeBlocks.push_back(std::make_unique<char[]>(size));
+		usedBefore += size;
+		return largeBlocks.back().get();
+	}
+
+	size_t offset = (blockUsed + alignment - 1) & ~(alignment - 1);
+	if (blocks.empty() || offset + size > BLOCK_SIZE) {
+		nextBlock();
+		offset = 0;
+	}
+
+	blockUsed = offset + size;
+	return blocks[blockIndex].get() + offset;
+}
+
+void AstArena::nextBlock() {
+	if (!blocks.empty()) {
+		usedBefore += blockUsed;
+		blockIndex++;
+	}
+	if (blockIndex == blocks.size()) {
+		blocks.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+	}
+	blockUsed = 0;
+}
+
+void AstArena::release() {
+	largeBlocks.clear();
+	blockIndex = 0;
+	blockUsed = 0;
+	usedBefore = 0;
+}
\ No newline at end of file
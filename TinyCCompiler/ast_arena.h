@@ -0,0 +1,69 @@
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Contiguous run of arena-allocated elements.
+template <class T>
+struct ArenaSpan {
+	T* data;
+	uint32_t count;
+
+	ArenaSpan() : data(nullptr), count(0) {};
+	ArenaSpan(T* _data, uint32_t _count) : data(_data), count(_count) {};
+
+	size_t size() const { return count; }
+	T& operator[](size_t i) const { return data[i]; }
+	T* begin() const { return data; }
+	T* end() const { return data + count; }
+};
+
+// Bump-pointer arena for AST nodes. Nodes are placement-constructed and never
+// destroyed one by one, so they must be trivially destructible; release() frees
+// the whole tree at once and keeps the blocks for the next compilation.
+class AstArena {
+public:
+	AstArena();
+	AstArena(const AstArena&) = delete;
+	AstArena& operator=(const AstArena&) = delete;
+
+	void* allocate(size_t size, size_t alignment);
+
+	template <class T, class... Args>
+	T* make(Args&&... args) {
+		static_assert(std::is_trivially_destructible<T>::value, "Arena nodes are never destroyed");
+		return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	// Copies a range into the arena, e.g. the children collected while parsing a block.
+	template <class T>
+	ArenaSpan<T> copy(const T* first, const T* last) {
+		static_assert(std::is_trivially_copyable<T>::value, "Arena arrays are copied bytewise");
+		uint32_t count = uint32_t(last - first);
+		if (count == 0) { return ArenaSpan<T>(); }
+		T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+		std::uninitialized_copy(first, last, data);
+		return ArenaSpan<T>(data, count);
+	}
+
+	void release();
+	size_t bytesUsed() const { return usedBefore + blockUsed; }
+private:
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	std::vector<std::unique_ptr<char[]>> blocks;
+	std::vector<std::unique_ptr<char[]>> largeBlocks; // Allocations over a quarter block
+	size_t blockIndex;
+	size_t blockUsed;
+	size_t usedBefore; // Bytes handed out from the blocks before the current one
+
+	void nextBlock();
+};
+
+#endif
\ No newline at end of file
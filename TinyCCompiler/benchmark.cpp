@@ -0,0 +1,417 @@
+#include "benchmark.h"
+#include "keywords.h"
+#include "dfa_lexer.h"
+#include "lexer.h"
+#include "parser.h"
+#include "code_generator.h"
+#include "program_generator.h"
+#include "token_stream.h"
+#include "parallel_lexer.h"
+#include "incremental_lexer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// Keyword classification as it was done by Lexer before the perfect hash: one
+// std::string per identifier and a comparison against every keyword.
+static TokenType classifyKeywordByComparison(std::string_view word) {
+	std::string str(word);
+
+	if (str == "int") { return TokenType::IntType; }
+	if (str == "float") { return TokenType::FloatType; }
+	if (str == "return") { return TokenType::ReturnKeyword; }
+	if (str == "if") { return TokenType::IfOperator; }
+	if (str == "else") { return TokenType::ElseOperator; }
+
+	return TokenType::FAILED;
+}
+
+template <class TClassify>
+static double measureNanosecondsPerLookup(const std::vector<std::string>& words, int rounds, TClassify classify, size_t& keywordCount) {
+	keywordCount = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int round = 0; round < rounds; round++) {
+		for (const std::string& word : words) {
+			keywordCount += classify(word) != TokenType::FAILED;
+		}
+	}
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+	return elapsed.count() / (double(words.size()) * rounds);
+}
+
+void runKeywordBenchmark(std::ostream& out) {
+	// Identifier mix resembling real code: a quarter keywords, the rest names of 1 to 24 characters
+	std::mt19937 random(12345);
+	std::vector<std::string> words;
+	const char* alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+	for (int i = 0; i < 100000; i++) {
+		if (random() % 4 == 0) {
+			words.push_back(std::string(KEYWORDS[random() % std::size(KEYWORDS)].word));
+			continue;
+		}
+
+		std::string word(1, alphabet[random() % 52]);
+		size_t length = 1 + random() % 24;
+		while (word.size() < length) { word += alphabet[random() % 63]; }
+		words.push_back(word);
+	}
+
+	const int rounds = 50;
+	size_t hashKeywords, comparisonKeywords;
+	double comparison = measureNanosecondsPerLookup(words, rounds, classifyKeywordByComparison, comparisonKeywords);
+	double hash = measureNanosecondsPerLookup(words, rounds, classifyKeyword, hashKeywords);
+
+	out << "keyword lookup over " << words.size() << " identifiers x " << rounds << " rounds\n";
+	out << "  string comparison: " << comparison << " ns/lookup\n";
+	out << "  perfect hash:      " << hash << " ns/lookup\n";
+	out << "  speedup:           " << comparison / hash << "x\n";
+	if (hashKeywords != comparisonKeywords) {
+		out << "  MISMATCH: " << hashKeywords << " vs " << comparisonKeywords << " keywords found\n";
+	}
+}
+
+template <class TFunction>
+static double bestSeconds(int repeat, TFunction function) {
+	double best = 0;
+	for (int i = 0; i < repeat; i++) {
+		auto start = std::chrono::steady_clock::now();
+		function();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		best = (i == 0 || seconds < best) ? seconds : best;
+	}
+	return best;
+}
+
+static size_t countNodes(const BlockAST& block);
+
+static size_t countNodes(const ExprAST& expr) {
+	switch (expr.type) {
+	case ExpressionType::EXPR_UNARY:
+		return 1 + countNodes(*expr.unary.expr);
+	case ExpressionType::EXPR_BINARY:
+		return 1 + countNodes(*expr.binary.left) + countNodes(*expr.binary.right);
+	case ExpressionType::EXPR_ASSIGNMENT:
+		return 1 + countNodes(*expr.varAssignment.expr);
+	default:
+		return 1;
+	}
+}
+
+static size_t countNodes(const StatementAST& statement) {
+	switch (statement.type) {
+	case StatementType::BLOCK:
+		return 1 + countNodes(*statement.block);
+	case StatementType::CONDITION: {
+		const ConditionAST& condition = *statement.condition;
+		size_t nodes = 2 + countNodes(*condition.expr) + countNodes(*condition.ifClause);
+		return condition.elseClause ? nodes + countNodes(*condition.elseClause) : nodes;
+	}
+	default:
+		return 1 + countNodes(*statement.expr);
+	}
+}
+
+static size_t countNodes(const BlockAST& block) {
+	size_t nodes = 1;
+	for (auto& item : block.items) {
+		if (item->type == BlockItemType::DECLARATION) {
+			nodes += 2 + (item->declaration->expr ? countNodes(*item->declaration->expr) : 0);
+		}
+		else {
+			nodes += 1 + countNodes(*item->statement);
+		}
+	}
+	return nodes;
+}
+
+int runPipelineBenchmark(int argc, char* argv[], std::ostream& out) {
+	GeneratorOptions options;
+	int repeat = 5;
+	int jobs = int(std::max(1u, std::thread::hardware_concurrency()));
+	std::string dumpFile;
+
+	for (int i = 0; i < argc; i++) {
+		const char* value = std::strchr(argv[i], '=');
+		if (!value) {
+			out << "Wrong benchmark option: " << argv[i] << std::endl;
+			return -1;
+		}
+		std::string key(argv[i], value - argv[i]);
+		value++;
+
+		if (key == "size") { options.targetBytes = std::stoul(value); }
+		else if (key == "depth") { options.expressionDepth = std::stoi(value); }
+		else if (key == "nesting") { options.nesting = std::stoi(value); }
+		else if (key == "idlen") { options.identifierLength = std::stoi(value); }
+		else if (key == "functions") { options.functions = std::max(1, std::stoi(value)); }
+		else if (key == "seed") { options.seed = uint32_t(std::stoul(value)); }
+		else if (key == "repeat") { repeat = std::max(1, std::stoi(value)); }
+		else if (key == "jobs") { jobs = std::max(1, std::stoi(value)); }
+		else if (key == "dump") { dumpFile = value; }
+		else {
+			out << "Wrong benchmark option: " << argv[i] << std::endl;
+			return -1;
+		}
+	}
+
+	std::string source = generateProgram(options);
+	if (!dumpFile.empty()) {
+		std::ofstream(dumpFile, std::ofstream::binary) << source;
+	}
+
+	size_t tokenCount = 0;
+	double lexSeconds = bestSeconds(repeat, [&] {
+		StringInterner symbols;
+		TokenStream tokens(source);
+		DfaLexer lexer(source, &symbols);
+		while (true) {
+			tokens.push_back(lexer.getNextToken());
+			if (tokens[tokens.size() - 1].type == TokenType::End) { break; }
+		}
+		tokenCount = tokens.size();
+	});
+
+	double legacyLexSeconds = bestSeconds(repeat, [&] {
+		StringInterner symbols;
+		TokenStream tokens(source);
+		Lexer lexer(source, &symbols);
+		while (true) {
+			tokens.push_back(lexer.getNextToken());
+			if (tokens[tokens.size() - 1].type == TokenType::End) { break; }
+		}
+	});
+
+	ThreadPool pool(jobs);
+	double parallelLexSeconds = bestSeconds(repeat, [&] {
+		StringInterner symbols;
+		TokenStream tokens(source);
+		lexInParallel(source, &symbols, tokens, pool);
+	});
+
+	StringInterner symbols;
+	TokenStream tokens(source);
+	DfaLexer lexer(source, &symbols);
+	while (true) {
+		tokens.push_back(lexer.getNextToken());
+		if (tokens[tokens.size() - 1].type == TokenType::End) { break; }
+	}
+
+	// The arena is rewound before each run, so repeated parses reuse its blocks
+	AstArena arena;
+	ProgramAST* ast = nullptr;
+	double parseSeconds = bestSeconds(repeat, [&] {
+		arena.release();
+		Parser parser(tokens, arena);
+		ast = parser.Parse();
+	});
+	if (!ast) {
+		out << "Generated program was rejected by the parser" << std::endl;
+		return -1;
+	}
+	size_t nodeCount = 1;
+	for (FunctionAST* function : ast->functions) { nodeCount += 1 + countNodes(*function->block); }
+
+	AstArena chainArena;
+	ProgramAST* chainAst = nullptr;
+	double chainParseSeconds = bestSeconds(repeat, [&] {
+		chainArena.release();
+		Parser parser(tokens, chainArena, ExpressionParsing::RECURSIVE_DESCENT);
+		chainAst = parser.Parse();
+	});
+
+	std::string asmCode;
+	double codegenSeconds = bestSeconds(repeat, [&] {
+		CodeGenerator codeGen(symbols);
+		asmCode = codeGen.generateCode(*ast);
+	});
+	size_t asmBytes = asmCode.size();
+
+	FlatAST flatAst;
+	double flatParseSeconds = bestSeconds(repeat, [&] {
+		flatAst.clear();
+		FlatParser parser(tokens, flatAst);
+		parser.Parse();
+	});
+
+	double flatCodegenSeconds = bestSeconds(repeat, [&] {
+		CodeGenerator codeGen(symbols);
+		if (codeGen.generateCode(flatAst) != asmCode) { asmBytes = 0; }
+	});
+	if (asmBytes == 0) {
+		out << "Flat AST code differs from tree AST code" << std::endl;
+		return -1;
+	}
+	if (!chainAst || CodeGenerator(symbols).generateCode(*chainAst) != asmCode) {
+		out << "Recursive descent expressions differ from precedence climbing" << std::endl;
+		return -1;
+	}
+
+	double parallelCodegenSeconds = bestSeconds(repeat, [&] {
+		CodeGenerator codeGen(symbols, &pool);
+		if (codeGen.generateCode(*ast) != asmCode) { asmBytes = 0; }
+	});
+	if (asmBytes == 0) {
+		out << "Parallel code generation differs from serial code generation" << std::endl;
+		return -1;
+	}
+
+	double megabytes = double(source.size()) / (1024 * 1024);
+	out << "{\"benchmark\": \"pipeline\""
+		<< ", \"seed\": " << options.seed
+		<< ", \"depth\": " << options.expressionDepth
+		<< ", \"nesting\": " << options.nesting
+		<< ", \"idlen\": " << options.identifierLength
+		<< ", \"functions\": " << ast->functions.size()
+		<< ", \"repeat\": " << repeat
+		<< ", \"source_bytes\": " << source.size()
+		<< ", \"tokens\": " << tokenCount
+		<< ", \"nodes\": " << nodeCount
+		<< ", \"ast_bytes\": " << arena.bytesUsed()
+		<< ", \"flat_ast_bytes\": " << flatAst.memoryBytes()
+		<< ", \"asm_bytes\": " << asmBytes
+		<< ", \"lex_mb_per_s\": " << megabytes / lexSeconds
+		<< ", \"lex_tokens_per_s\": " << tokenCount / lexSeconds
+		<< ", \"legacy_lex_mb_per_s\": " << megabytes / legacyLexSeconds
+		<< ", \"legacy_lex_tokens_per_s\": " << tokenCount / legacyLexSeconds
+		<< ", \"jobs\": " << jobs
+		<< ", \"parallel_lex_mb_per_s\": " << megabytes / parallelLexSeconds
+		<< ", \"parse_nodes_per_s\": " << nodeCount / parseSeconds
+		<< ", \"recursive_parse_nodes_per_s\": " << nodeCount / chainParseSeconds
+		<< ", \"codegen_bytes_per_s\": " << asmBytes / codegenSeconds
+		<< ", \"parallel_codegen_bytes_per_s\": " << asmBytes / parallelCodegenSeconds
+		<< ", \"flat_parse_nodes_per_s\": " << nodeCount / flatParseSeconds
+		<< ", \"flat_codegen_bytes_per_s\": " << asmBytes / flatCodegenSeconds
+		<< "}" << std::endl;
+	return 0;
+}
+
+static bool sameTokenStreams(const TokenStream& serial, const StringInterner& serialSymbols, const TokenStream& parallel, const StringInterner& parallelSymbols) {
+	if (serial.size() != parallel.size() || serialSymbols.size() != parallelSymbols.size()) { return false; }
+
+	for (size_t i = 0; i < serial.size(); i++) {
+		const CompactToken& a = serial[i];
+		const CompactToken& b = parallel[i];
+		if (a.type != b.type || a.offset != b.offset || a.length != b.length || a.outOfRange != b.outOfRange || a.symbol != b.symbol) { return false; }
+		if (serial.line(a) != parallel.line(b) || serial.position(a) != parallel.position(b)) { return false; }
+	}
+
+	for (Symbol symbol = 0; symbol < serialSymbols.size(); symbol++) {
+		if (serialSymbols.name(symbol) != parallelSymbols.name(symbol)) { return false; }
+	}
+	return true;
+}
+
+int runParallelLexerCheck(std::ostream& out) {
+	std::mt19937 random(2024);
+	ThreadPool pool(4);
+	const char* soup = "abz_019.  \n\n\t\r(){};~-!+*/<>&|=0b if int else return float %";
+	size_t soupSize = std::strlen(soup);
+
+	for (int iteration = 0; iteration < 500; iteration++) {
+		std::string source;
+		if (iteration % 2 == 0) {
+			GeneratorOptions options;
+			options.targetBytes = 1 + random() % 20000;
+			options.expressionDepth = 1 + random() % 6;
+			options.nesting = 1 + random() % 5;
+			options.identifierLength = 1 + random() % 30;
+			options.seed = random();
+			source = generateProgram(options);
+		}
+		else {
+			size_t size = random() % 5000;
+			for (size_t i = 0; i < size; i++) { source += soup[random() % soupSize]; }
+		}
+
+		StringInterner serialSymbols;
+		TokenStream serial(source);
+		DfaLexer lexer(source, &serialSymbols);
+		while (true) {
+			serial.push_back(lexer.getNextToken());
+			if (serial[serial.size() - 1].type == TokenType::End) { break; }
+		}
+
+		// Small chunks so that even short inputs are split many times
+		StringInterner parallelSymbols;
+		TokenStream parallel(source);
+		lexInParallel(source, &parallelSymbols, parallel, pool, 1 + random() % 512);
+
+		if (!sameTokenStreams(serial, serialSymbols, parallel, parallelSymbols)) {
+			out << "Parallel lexer mismatch in iteration " << iteration << std::endl;
+			return -1;
+		}
+	}
+
+	out << "Parallel lexer matches the serial lexer on 500 random inputs" << std::endl;
+	return 0;
+}
+
+static void lexAll(std::string_view source, StringInterner& symbols, TokenStream& tokens) {
+	DfaLexer lexer(source, &symbols);
+	while (true) {
+		tokens.push_back(lexer.getNextToken());
+		if (tokens[tokens.size() - 1].type == TokenType::End) { break; }
+	}
+}
+
+int runIncrementalLexerCheck(std::ostream& out) {
+	std::mt19937 random(77);
+	const char* soup = "abz_019.  \n\n\t(){};~-!+*/<>&|=0b if int else return %";
+	size_t soupSize = std::strlen(soup);
+	size_t edits = 0, relexedTokens = 0, totalTokens = 0;
+
+	for (int program = 0; program < 50; program++) {
+		GeneratorOptions options;
+		options.targetBytes = 1000 + random() % 20000;
+		options.seed = random();
+		std::string source = generateProgram(options);
+
+		StringInterner symbols;
+		TokenStream tokens(source);
+		lexAll(source, symbols, tokens);
+		tokens.line(tokens[0]); // Build the line table so that edits have to maintain it
+
+		for (int i = 0; i < 200; i++) {
+			std::string inserted;
+			size_t insertedSize = random() % 8;
+			for (size_t k = 0; k < insertedSize; k++) { inserted += soup[random() % soupSize]; }
+
+			uint32_t offset = uint32_t(random() % (source.size() + 1));
+			uint32_t removed = uint32_t(std::min<size_t>(random() % 8, source.size() - offset));
+
+			// The token stream views the old buffer until relex() switches it to the new one
+			std::string edited = source.substr(0, offset) + inserted + source.substr(offset + removed);
+			relexedTokens += relex(tokens, edited, { offset, removed, inserted }, &symbols);
+			source.swap(edited);
+			edits++;
+
+			StringInterner freshSymbols;
+			TokenStream fresh(source);
+			lexAll(source, freshSymbols, fresh);
+			totalTokens += fresh.size();
+
+			bool same = fresh.size() == tokens.size();
+			for (size_t k = 0; same && k < fresh.size(); k++) {
+				const CompactToken& a = fresh[k];
+				const CompactToken& b = tokens[k];
+				same = a.type == b.type && a.offset == b.offset && a.length == b.length && a.outOfRange == b.outOfRange
+					&& fresh.line(a) == tokens.line(b) && fresh.position(a) == tokens.position(b)
+					&& (a.type == TokenType::Identifier ? freshSymbols.name(a.symbol) == symbols.name(b.symbol) : a.intVal == b.intVal);
+			}
+			if (!same) {
+				out << "Incremental lexer mismatch in program " << program << ", edit " << i << std::endl;
+				return -1;
+			}
+		}
+	}
+
+	out << "Incremental lexer matches full lexing after " << edits << " random edits, re-lexing "
+		<< double(relexedTokens) / edits << " of " << double(totalTokens) / edits << " tokens per edit on average" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <ostream>
+
+// Compares the perfect-hash keyword lookup with the former chain of string comparisons.
+void runKeywordBenchmark(std::ostream& out);
+
+// Measures lexer, parser and code generator throughput on a generated program and
+// prints one JSON object with the results. Options are "key=value" arguments:
+// size, depth, nesting, idlen, functions, seed, repeat, jobs and dump (file to save the program to).
+int runPipelineBenchmark(int argc, char* argv[], std::ostream& out);
+
+// Lexes random inputs serially and in parallel and checks that the token streams
+// and line tables are identical. Returns non-zero on the first mismatch.
+int runParallelLexerCheck(std::ostream& out);
+
+// Applies random edits to generated programs, re-lexes them incrementally and checks
+// the result against lexing the edited source from scratch.
+int runIncrementalLexerCheck(std::ostream& out);
+
+#endif
\ No newline at end of file
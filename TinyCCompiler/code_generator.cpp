@@ -1,9 +1,37 @@
 #include "code_generator.h"
+#include "ir_lowering.h"
 
+#include <algorithm>
+#include <chrono>
 #include <exception>
-#include <limits>
+#include <iterator>
+#include <sstream>
 
-CodeGenerator::CodeGenerator() {
+static const X86Register REGISTERS[] = { X86Register::EBX, X86Register::ECX, X86Register::ESI, X86Register::EDI, X86Register::EAX };
+static const X86Register REGISTER_WORDS[] = { X86Register::BX, X86Register::CX, X86Register::SI, X86Register::DI, X86Register::AX };
+// COUNT where the register has no byte register
+static const X86Register REGISTER_BYTES[] = { X86Register::BL, X86Register::CL, X86Register::COUNT, X86Register::COUNT, X86Register::AL };
+
+static X86Operand reg(CodeGenerator::Register reg) { return x86Register(REGISTERS[size_t(reg)]); }
+
+static const X86Operand EBX = x86Register(X86Register::EBX);
+static const X86Operand EBP = x86Register(X86Register::EBP);
+static const X86Operand ESP = x86Register(X86Register::ESP);
+static const X86Operand NONE = { X86OperandKind::NONE, X86Register::COUNT, 0 };
+
+static void emit(X86Code& code, X86Op op, X86Operand first = NONE, X86Operand second = NONE)
+{
+	code.push_back({ op, { first, second } });
+}
+
+// The result is left in ebx; esi and edi need no saving, since functions are only entered
+// from the startup code, which keeps nothing in them
+static const CodeGenerator::Register EXPRESSION_REGISTERS[] = {
+	CodeGenerator::Register::EBX, CodeGenerator::Register::ECX, CodeGenerator::Register::ESI, CodeGenerator::Register::EDI
+};
+
+CodeGenerator::CodeGenerator(const StringInterner& _symbols, ThreadPool* _pool, IrOptions _irOptions)
+	: symbols(_symbols), pool(_pool), irOptions(_irOptions), passes(IrPassManager::standard(_irOptions.verify)), expressionRoot(nullptr) {
 	header = std::string(".386\n"
 		".model flat, stdcall\n"
 		"option casemap : none\n"
@@ -14,32 +42,74 @@ CodeGenerator::CodeGenerator() {
 		"includelib masm32\\lib\\masm32.lib\n\n");
 	functionProtos = "NumbToStr   PROTO :DWORD,:DWORD\n";
 	dataSection = "buff        db 11 dup(?)\n";
-	codeSection = "";
 }
 
 
+void CodeGenerator::generateCode(ProgramAST& item, CodeSink& out)
+{
+	std::vector<std::string_view> names;
+	for (FunctionAST* function : item.functions) {
+		checkFunctionName(function->name, function->offset);
+		names.push_back(symbols.name(function->name));
+	}
+
+	programStart(names, out);
+	generateFunctions(item.functions.size(), out, [&](CodeGenerator& generator, size_t i, CodeSink& code) {
+		generator.generateCode(*item.functions[i], code);
+	});
+	programEnd(out);
+}
+
 std::string CodeGenerator::generateCode(ProgramAST& item)
 {
-	std::string code;
-	code += header;
+	CodeSink code;
+	generateCode(item, code);
+	return code.take();
+}
+
+void CodeGenerator::checkFunctionName(Symbol name, uint32_t offset)
+{
+	if (!functionNames.insert(name).second) {
+		diagnostics.report(DiagnosticCode::REDEFINED_FUNCTION, offset);
+	}
+}
+
+std::string CodeGenerator::programCode(const std::vector<std::string_view>& names, const std::vector<std::string>& functionCodes)
+{
+	CodeSink code;
+	programStart(names, code);
+	for (const std::string& funcCode : functionCodes) {
+		code << funcCode << '\n';
+	}
+	programEnd(code);
+	return code.take();
+}
+
+void CodeGenerator::programStart(const std::vector<std::string_view>& names, CodeSink& out)
+{
+	for (std::string_view name : names) {
+		functionProtos += std::string(name) + " PROTO\n";
+	}
+
+	out << header;
 	
-	std::string progCode = std::string(
+	std::string_view progCode =
 		"start:\n"
 		"call main\n"
 		"invoke  NumbToStr, ebx, ADDR buff\n"
 		"invoke  StdOut, eax\n"
-		"invoke ExitProcess, 0\n"
-	);
-
-	std::string funcCode = generateCode(*item.function);
-
-	code += functionProtos;
-	code += ".data\n";
-	code += dataSection;
-	code += ".code\n";
-	code += progCode + '\n';
-	code += funcCode + '\n';
-	code += "NumbToStr PROC uses ebx x:DWORD,buffer:DWORD\n"
+		"invoke ExitProcess, 0\n";
+
+	out << functionProtos;
+	out << ".data\n";
+	out << dataSection;
+	out << ".code\n";
+	out << progCode << '\n';
+}
+
+void CodeGenerator::programEnd(CodeSink& out)
+{
+	out << "NumbToStr PROC uses ebx x:DWORD,buffer:DWORD\n"
 		"mov     ecx, buffer\n"
 		"mov     eax, x\n"
 		"mov     ebx, 10\n"
@@ -73,279 +143,429 @@ std::string CodeGenerator::generateCode(ProgramAST& item)
 		"ret\n"
 		"NumbToStr ENDP\n"
 		"end start\n";
+	out.flush();
+}
 
-	return code;
+void CodeGenerator::generateCode(FunctionAST& item, CodeSink& out)
+{
+	functionCode(symbols.name(item.name), [&](IrFunction& function) {
+		lowerFunction(item, function, diagnostics);
+	}, out);
 }
 
 std::string CodeGenerator::generateCode(FunctionAST& item)
 {
-	stackIndex = -4;
-	functionProtos += item.name + " PROTO\n";
-	std::string functionCode = item.name + std::string(" PROC\n");
+	CodeSink code;
+	generateCode(item, code);
+	return code.take();
+}
 
-	// Prologue
-	functionCode += "push ebp\n"
-					"mov ebp, esp\n";
-
-	functionCode += generateCode(*item.block);
-
-	//int offset = 0;
-	//for (auto item : varMaps[varMaps.size() - 1]) {
-	//	offset = std::max(offset, -item.second);
-	//}
-	//functionCode += "add esp, " + std::to_string(offset) + "\n";
-
-	// Epilogue 
-	functionCode += "mov esp, ebp\n"
-					"pop ebp\n";
-	functionCode += "ret\n";
-	functionCode += item.name + std::string(" ENDP\n");
-	return functionCode;
+void CodeGenerator::generateCode(const FlatAST& ast, CodeSink& out)
+{
+	const NodeIndex program = ast.root();
+	const NodeIndex* functions = ast.children(program);
+	std::vector<std::string_view> names;
+	for (uint32_t i = 0; i < ast.childCount(program); i++) {
+		checkFunctionName(ast.name(functions[i]), ast.nameOffset(functions[i]));
+		names.push_back(symbols.name(ast.name(functions[i])));
+	}
+
+	programStart(names, out);
+	generateFunctions(ast.childCount(program), out, [&](CodeGenerator& generator, size_t i, CodeSink& code) {
+		generator.generateCode(ast, functions[i], code);
+	});
+	programEnd(out);
 }
 
-std::string CodeGenerator::generateCode(BlockAST& item)
+std::string CodeGenerator::generateCode(const FlatAST& ast)
 {
-	varMaps.push_back(std::unordered_map<std::string, int>());
-	std::string code;
+	CodeSink code;
+	generateCode(ast, code);
+	return code.take();
+}
 
-	for (int i = 0; i < item.items.size(); i++) {
-		code += generateCode(*(item.items[i]));
+void CodeGenerator::generateCode(const FlatAST& ast, NodeIndex function, CodeSink& out)
+{
+	functionCode(symbols.name(ast.name(function)), [&](IrFunction& ir) {
+		lowerFunction(ast, function, ir, diagnostics);
+	}, out);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <class TLower>
+void CodeGenerator::functionCode(std::string_view name, TLower lower, CodeSink& out)
+{
+	IrFunction function(name);
+	auto start = std::chrono::steady_clock::now();
+	lower(function);
+	timings.add("lowering", secondsSince(start));
+	if (irOptions.verify) {
+		IrPassManager::check(function, "lowering");
 	}
 
-	for (int i = 0; i < varMaps.size(); i++) {
-		code += "pop ecx\n";
+	passes.run(function, timings);
+	if (irOptions.dump) {
+		std::ostringstream text;
+		printIr(function, text);
+		irDump += text.str();
 	}
-	varMaps.pop_back();
-	return code;
+
+	start = std::chrono::steady_clock::now();
+	X86Code code;
+	emitFunction(function, code);
+	timings.add("x86 emission", secondsSince(start));
+
+	start = std::chrono::steady_clock::now();
+	optimizePeephole(code, peepholeStats);
+	timings.add("peephole", secondsSince(start));
+
+	start = std::chrono::steady_clock::now();
+	out << name << " PROC\n";
+	printX86(code, out);
+	out << name << " ENDP\n";
+	timings.add("x86 emission", secondsSince(start));
+}
+
+void CodeGenerator::absorb(const CodeGenerator& generator)
+{
+	diagnostics.append(generator.diagnostics);
+	irDump += generator.irDump;
+	timings.append(generator.timings);
+	peepholeStats.append(generator.peepholeStats);
+}
+
+static bool hasPhis(const IrBlock* block)
+{
+	return block->first && block->first->op == IrOp::PHI;
 }
 
-std::string CodeGenerator::generateCode(StatementAST& item)
+// Where the user needs the value: at the end of the incoming block for a phi
+static const IrInstruction* usedBy(const IrInstruction* user, const IrInstruction* value)
 {
-	std::string code;
-	if (item.type == StatementType::EXPRESSION_STATEMENT) {
-		code = generateCode(*item.expr);
+	if (user->op != IrOp::PHI) { return user; }
+	for (const IrPhiInput& input : user->incoming) {
+		if (input.value == value) {
+			return input.block->last;
+		}
 	}
-	else if (item.type == StatementType::RETURN_STATEMENT) {
-		code = generateCode(*item.expr);
+	return user;
+}
+
+// A phi that its block only returns is left in ebx by the edges into the block
+static bool returnedPhi(const IrInstruction* phi)
+{
+	return phi == phi->block->first && phi->next->op == IrOp::RETURN && phi->next->operands[0] == phi;
+}
+
+void CodeGenerator::emitFunction(const IrFunction& function, X86Code& code)
+{
+	size_t count = function.valueCount();
+	useCounts.assign(count, 0);
+	inlined.assign(count, false);
+	slots.assign(count, 0);
+
+	std::vector<const IrInstruction*> users(count, nullptr);
+	for (const IrBlock* block : function.blocks) {
+		for (const IrInstruction* instruction = block->first; instruction; instruction = instruction->next) {
+			for (int i = 0; i < operandCount(instruction->op); i++) {
+				useCounts[instruction->operands[i]->id]++;
+				users[instruction->operands[i]->id] = instruction;
+			}
+			for (const IrPhiInput& input : instruction->incoming) {
+				useCounts[input.value->id]++;
+				users[input.value->id] = instruction;
+			}
+		}
+	}
+
+	// Constants and undefined values are written into the instructions using them
+	int32_t frameBytes = 0;
+	for (const IrBlock* block : function.blocks) {
+		for (const IrInstruction* instruction = block->first; instruction; instruction = instruction->next) {
+			if (instruction->type == IrType::VOID) { continue; }
+			uint32_t id = instruction->id;
+			bool operation = operandCount(instruction->op) > 0;
+			inlined[id] = operation && useCounts[id] == 1 && usedBy(users[id], instruction)->block == block;
+			if ((instruction->op == IrOp::PHI && !returnedPhi(instruction)) || (operation && useCounts[id] > 0 && !inlined[id])) {
+				frameBytes += 4;
+				slots[id] = -frameBytes;
+			}
+		}
 	}
-	else if (item.type == StatementType::BLOCK) {
-		code += generateCode(*item.block);
+
+	// Prologue
+	emit(code, X86Op::PUSH, EBP);
+	emit(code, X86Op::MOV, EBP, ESP);
+	if (frameBytes > 0) {
+		emit(code, X86Op::SUB, ESP, x86Immediate(frameBytes));
 	}
-	else if(item.type == StatementType::CONDITION) {
-		code += generateCode(*item.condition);
+
+	for (size_t i = 0; i < function.blocks.size(); i++) {
+		blockCode(function.blocks[i], i + 1 < function.blocks.size() ? function.blocks[i + 1] : nullptr, code);
 	}
-	return code;
 }
 
-std::string CodeGenerator::generateCode(ExprAST& item) {
-	if (item.type == ExpressionType::EXPR_INT) {
-		return "mov ebx, " + std::to_string(item.intVal) + "\n";
+void CodeGenerator::blockCode(const IrBlock* block, const IrBlock* next, X86Code& code)
+{
+	if (block->predecessors.size() > 0) {
+		emit(code, X86Op::LABEL, x86Block(block->id));
 	}
-	else if (item.type == ExpressionType::EXPR_UNARY) {
-		if (item.unary.unOp == TokenType::Negation) {
-			std::string code = generateCode(*item.unary.expr);
-			code += "neg ebx\n";
-			return code;
-		}
-		else if (item.unary.unOp == TokenType::BitwiseComplement) {
-			std::string code = generateCode(*item.unary.expr);
-			code += "not ebx\n";
-			return code;
+
+	for (const IrInstruction* instruction = block->first; instruction; instruction = instruction->next) {
+		switch (instruction->op) {
+		case IrOp::CONST:
+		case IrOp::UNDEF:
+		case IrOp::PHI:
+			break;
+		case IrOp::JUMP:
+			edgeCode(block, instruction->targets[0], next, code);
+			break;
+		case IrOp::BRANCH: {
+			const IrBlock* ifTrue = instruction->targets[0];
+			const IrBlock* ifFalse = instruction->targets[1];
+			operandCode(instruction->operands[0], code);
+			emit(code, X86Op::CMP, EBX, x86Immediate(0));
+			if (!hasPhis(ifFalse)) {
+				emit(code, X86Op::JE, x86Block(ifFalse->id));
+				edgeCode(block, ifTrue, next, code);
+			}
+			else if (!hasPhis(ifTrue)) {
+				emit(code, X86Op::JNE, x86Block(ifTrue->id));
+				edgeCode(block, ifFalse, next, code);
+			}
+			else {
+				// Both edges copy values, so the false one gets code of its own
+				emit(code, X86Op::JE, x86Edge(block->id));
+				edgeCode(block, ifTrue, nullptr, code);
+				emit(code, X86Op::LABEL, x86Edge(block->id));
+				edgeCode(block, ifFalse, next, code);
+			}
+			break;
 		}
-		else if (item.unary.unOp == TokenType::LogicalNegation) {
-			std::string code = generateCode(*item.unary.expr);
-			code += "cmp ebx, 0\n"
-				"mov ebx, 0\n"
-				"sete bl\n";
-			return code;
+		case IrOp::RETURN:
+			operandCode(instruction->operands[0], code);
+
+			// Epilogue
+			emit(code, X86Op::MOV, ESP, EBP);
+			emit(code, X86Op::POP, EBP);
+			emit(code, X86Op::RET);
+			break;
+		default:
+			if (inlined[instruction->id]) { break; }
+			// Dead code elimination leaves no unused values, but they would still be computed
+			expressionCode(instruction, code);
+			if (slots[instruction->id] != 0) {
+				emit(code, X86Op::MOV, x86Frame(slots[instruction->id]), EBX);
+			}
+			break;
 		}
 	}
-	else if (item.type == ExpressionType::EXPR_VARIABLE) {
-		int offset = findVariableOffset(item.varName);
-		if (offset == INT_MAX) {
-			throw std::runtime_error("Undeclared variable!");
-		}
-		std::string code = "mov ebx, [ebp" + std::to_string(offset) + "]\n";
-		return code;
-	}
-	else if (item.type == ExpressionType::EXPR_BINARY) {
-		if (item.binary.binOp == TokenType::Addition) {
-			std::string code = generateCode(*item.binary.left);
-			code += "push ebx\n";
-			code += generateCode(*item.binary.right);
-			code += "pop ecx\n";
-			code += "add ebx, ecx\n";
-
-			return code;
-		}
-		else if (item.binary.binOp == TokenType::Multiplication) {
-			std::string code = generateCode(*item.binary.left);
-			code += "push ebx\n";
-			code += generateCode(*item.binary.right);
-			code += "pop eax\n";
-			code += "mul ebx\n";
-			code += "mov ebx, eax\n";
-
-			return code;
-		}
-		else if (item.binary.binOp == TokenType::Negation) {
-			std::string code = generateCode(*item.binary.left);
-			code += "push ebx\n";
-			code += generateCode(*item.binary.right);
-			code += "pop ecx\n";
-			code += "sub ecx, ebx\n";
-			code += "mov ebx, ecx\n";
-
-			return code;
-		}
-		else if (item.binary.binOp == TokenType::Division) {
-			std::string code = generateCode(*item.binary.left);
-			code += "push ebx\n";
-			code += generateCode(*item.binary.right);
-			code += "pop eax\n";
-			code += "mov dx, 0\n";
-			code += "div bx\n";
-			code += "mov ebx, eax\n";
-
-			return code;
-		}
-		else if (item.binary.binOp == TokenType::LogicalAnd) {
-			std::string code = generateCode(*item.binary.left);
-			code += "push ebx\n";
-			code += generateCode(*item.binary.right);
-			code += "pop ecx\n";
-			code += "and ebx, ecx\n";
-
-			return code;
-		}
-		else if (item.binary.binOp == TokenType::LogicalOr) {
-			std::string code = generateCode(*item.binary.left);
-			code += "push ebx\n";
-			code += generateCode(*item.binary.right);
-			code += "pop ecx\n";
-			code += "or ebx, ecx\n";
-
-			return code;
-		}
-		else if (item.binary.binOp == TokenType::Equal) {
-			std::string code = generateCode(*item.binary.left);
-			code += "push ebx\n";
-			code += generateCode(*item.binary.right);
-			code += "pop eax\n";
-			code += "cmp eax, ebx\n";
-			code += "mov ebx, 0\n";
-			code += "sete bl\n";
-
-			return code;
+}
+
+void CodeGenerator::edgeCode(const IrBlock* from, const IrBlock* to, const IrBlock* next, X86Code& code)
+{
+	// The CFG has no loops, so no phi of to is an incoming value of another
+	for (const IrInstruction* phi = to->first; phi && phi->op == IrOp::PHI; phi = phi->next) {
+		const IrInstruction* value = nullptr;
+		for (const IrPhiInput& input : phi->incoming) {
+			if (input.block == from) {
+				value = input.value;
+			}
 		}
-		else if (item.binary.binOp == TokenType::NotEqual) {
-			std::string code = generateCode(*item.binary.left);
-			code += "push ebx\n";
-			code += generateCode(*item.binary.right);
-			code += "pop eax\n";
-			code += "cmp eax, ebx\n";
-			code += "mov ebx, 0\n";
-			code += "setne bl\n";
-
-			return code;
+
+		if (value->op == IrOp::UNDEF) { continue; }
+		if (slots[phi->id] == 0) {
+			operandCode(value, code);
 		}
-		else if (item.binary.binOp == TokenType::Less) {
-			std::string code = generateCode(*item.binary.left);
-			code += "push ebx\n";
-			code += generateCode(*item.binary.right);
-			code += "pop eax\n";
-			code += "cmp eax, ebx\n";
-			code += "mov ebx, 0\n";
-			code += "setl bl\n";
-
-			return code;
+		else if (value->op == IrOp::CONST) {
+			emit(code, X86Op::MOV, x86Frame(slots[phi->id]), x86Immediate(value->constant));
 		}
-		else if (item.binary.binOp == TokenType::Greater) {
-			std::string code = generateCode(*item.binary.left);
-			code += "push ebx\n";
-			code += generateCode(*item.binary.right);
-			code += "pop eax\n";
-			code += "cmp eax, ebx\n";
-			code += "mov ebx, 0\n";
-			code += "setg bl\n";
-
-			return code;
+		else {
+			operandCode(value, code);
+			emit(code, X86Op::MOV, x86Frame(slots[phi->id]), EBX);
 		}
 	}
-	else if (item.type == ExpressionType::EXPR_ASSIGNMENT) {
-		std::string code = generateCode(*item.varAssignment.expr);
-		int offset = findVariableOffset(item.varName);
-		
-		if (offset == INT_MAX) {
-			throw std::runtime_error("Undeclared variable!");
-		}
-		code += "mov [ebp" + std::to_string(offset) + "], ebx\n";
-		
-		return code;
+
+	if (to != next) {
+		emit(code, X86Op::JMP, x86Block(to->id));
 	}
 }
 
-std::string CodeGenerator::generateCode(DeclarationAST& item)
+void CodeGenerator::operandCode(const IrInstruction* value, X86Code& code)
 {
-	std::string code;
-	if (!item.expr) {
-		if (varMaps[varMaps.size() - 1].find(item.varName) != varMaps[varMaps.size() - 1].end()) {
-			throw std::runtime_error("Multiple variable declaration is prohibited!");
-		}
-
-		varMaps[varMaps.size() - 1].insert(std::make_pair(item.varName, stackIndex));
-		code += "push 0\n";
-		stackIndex -= 4;
+	if (value->op == IrOp::PHI && slots[value->id] == 0) {
+		// Already in ebx
+	}
+	else if (inlined[value->id]) {
+		expressionCode(value, code);
 	}
 	else {
-		if (varMaps[varMaps.size() - 1].find(item.varName) != varMaps[varMaps.size() - 1].end()) {
-			throw std::runtime_error("Multiple variable declaration is prohibited!");
-		}
+		leafCode(value, Register::EBX, code);
+	}
+}
 
-		varMaps[varMaps.size() - 1].insert(std::make_pair(item.varName, stackIndex));
-		code += generateCode(*item.expr);
-		code += "push ebx\n";
-		stackIndex -= 4;
+void CodeGenerator::expressionCode(const IrInstruction* root, X86Code& code)
+{
+	expressionRoot = root;
+	labels.clear();
+	labelExpression(root);
+	allocateExpression(root, 0, EXPRESSION_REGISTERS, std::size(EXPRESSION_REGISTERS), code);
+}
+
+// Whether node is evaluated as an operator of the tree, rather than loaded as a leaf
+bool CodeGenerator::expanded(const IrInstruction* node) const
+{
+	return (node == expressionRoot || inlined[node->id]) && operandCount(node->op) > 0;
+}
+
+void CodeGenerator::labelExpression(const IrInstruction* node)
+{
+	size_t index = labels.size();
+	labels.push_back({ 1, 1 });
+	if (!expanded(node)) { return; }
+
+	if (operandCount(node->op) == 1) {
+		labelExpression(node->operands[0]);
+		ExpressionLabel operand = labels[index + 1];
+		labels[index] = { 1 + operand.size, operand.registers };
+		return;
 	}
-	return code;
+
+	labelExpression(node->operands[0]);
+	ExpressionLabel left = labels[index + 1];
+	labelExpression(node->operands[1]);
+	ExpressionLabel right = labels[index + 1 + left.size];
+	int registers = left.registers == right.registers ? left.registers + 1 : std::max(left.registers, right.registers);
+	labels[index] = { 1 + left.size + right.size, uint8_t(std::min(registers, 255)) };
 }
 
-int CodeGenerator::findVariableOffset(std::string varName)
+// Evaluates the subtree labelled labels[index] into registers[0], using registers[0, count)
+void CodeGenerator::allocateExpression(const IrInstruction* node, size_t index, const Register* registers, size_t count, X86Code& code)
 {
-	for (int i = varMaps.size() - 1; i >= 0; i--) {
-		if (varMaps[i].find(varName) != varMaps[i].end()) {
-			return varMaps[i][varName];
-		}
+	Register target = registers[0];
+	if (!expanded(node)) {
+		leafCode(node, target, code);
+		return;
+	}
+	if (operandCount(node->op) == 1) {
+		allocateExpression(node->operands[0], index + 1, registers, count, code);
+		unaryCode(node->op, target, code);
+		return;
 	}
 
-	return INT_MAX;
+	size_t leftIndex = index + 1;
+	size_t rightIndex = leftIndex + labels[leftIndex].size;
+	ExpressionLabel left = labels[leftIndex];
+	ExpressionLabel right = labels[rightIndex];
+
+	if (count == 1 || (left.registers >= count && right.registers >= count)) {
+		// Both operands need every register: the left one waits on the stack
+		allocateExpression(node->operands[0], leftIndex, registers, count, code);
+		emit(code, X86Op::PUSH, reg(target));
+		allocateExpression(node->operands[1], rightIndex, registers, count, code);
+		emit(code, X86Op::POP, reg(Register::EAX));
+		binaryCode(node->op, Register::EAX, target, target, code);
+	}
+	else if (right.registers > left.registers) {
+		allocateExpression(node->operands[1], rightIndex, registers, count, code);
+		allocateExpression(node->operands[0], leftIndex, registers + 1, count - 1, code);
+		binaryCode(node->op, registers[1], target, target, code);
+	}
+	else {
+		allocateExpression(node->operands[0], leftIndex, registers, count, code);
+		allocateExpression(node->operands[1], rightIndex, registers + 1, count - 1, code);
+		binaryCode(node->op, target, registers[1], target, code);
+	}
 }
 
-std::string CodeGenerator::generateCode(BlockItemAST& item)
+void CodeGenerator::leafCode(const IrInstruction* value, Register target, X86Code& code)
 {
-	std::string code;
-	if (item.type == BlockItemType::DECLARATION) {
-		code += generateCode(*item.declaration);
+	if (value->op == IrOp::CONST) {
+		emit(code, X86Op::MOV, reg(target), x86Immediate(value->constant));
 	}
-	else if (item.type == BlockItemType::STATEMENT) {
-		code += generateCode(*item.statement);
+	else if (value->op != IrOp::UNDEF) {
+		emit(code, X86Op::MOV, reg(target), x86Frame(slots[value->id]));
 	}
+}
 
-	return code;
+void CodeGenerator::unaryCode(IrOp op, Register target, X86Code& code)
+{
+	if (op == IrOp::NEG) {
+		emit(code, X86Op::NEG, reg(target));
+	}
+	else if (op == IrOp::NOT) {
+		emit(code, X86Op::NOT, reg(target));
+	}
+	else if (op == IrOp::LOGICAL_NOT) {
+		emit(code, X86Op::CMP, reg(target), x86Immediate(0));
+		conditionFlagCode(X86Op::SETE, target, code);
+	}
+	else {
+		throw std::runtime_error("Unsupported unary operator!");
+	}
 }
 
-std::string CodeGenerator::generateCode(ConditionAST& item)
+// Sets target to 1 when the condition holds and to 0 otherwise
+void CodeGenerator::conditionFlagCode(X86Op set, Register target, X86Code& code)
 {
-	std::string code = generateCode(*item.expr);
-	code += "cmp ebx, 0\n";
-	code += item.elseClause ? "je LBL_ELSE\n" : "je LBL_POST_COND\n";
-	code += generateCode(*item.ifClause);
-	code += "jmp LBL_POST_COND\n";
-	if (item.elseClause) {
-		code += "LBL_ELSE:\n";
-		code += generateCode(*item.elseClause);
-	}
-	code += "LBL_POST_COND:\n";
-
-	return code;
+	X86Register byte = REGISTER_BYTES[size_t(target)];
+	if (byte != X86Register::COUNT) {
+		emit(code, X86Op::MOV, reg(target), x86Immediate(0));
+		emit(code, set, x86Register(byte));
+	}
+	else {
+		emit(code, set, x86Register(X86Register::AL));
+		emit(code, X86Op::MOVZX, reg(target), x86Register(X86Register::AL));
+	}
 }
+
+// target is either left or right
+void CodeGenerator::binaryCode(IrOp op, Register left, Register right, Register target, X86Code& code)
+{
+	Register other = target == left ? right : left;
+	switch (op) {
+	case IrOp::ADD:
+		emit(code, X86Op::ADD, reg(target), reg(other));
+		break;
+	case IrOp::MUL:
+		// The low half of the product, which is all mul left in ebx
+		emit(code, X86Op::IMUL, reg(target), reg(other));
+		break;
+	case IrOp::SUB:
+		if (target == left) {
+			emit(code, X86Op::SUB, reg(target), reg(right));
+		}
+		else {
+			emit(code, X86Op::NEG, reg(target));
+			emit(code, X86Op::ADD, reg(target), reg(left));
+		}
+		break;
+	case IrOp::DIV:
+		if (left != Register::EAX) {
+			emit(code, X86Op::MOV, reg(Register::EAX), reg(left));
+		}
+		emit(code, X86Op::MOV, x86Register(X86Register::DX), x86Immediate(0));
+		emit(code, X86Op::DIV, x86Register(REGISTER_WORDS[size_t(right)]));
+		emit(code, X86Op::MOV, reg(target), reg(Register::EAX));
+		break;
+	case IrOp::AND:
+		emit(code, X86Op::AND, reg(target), reg(other));
+		break;
+	case IrOp::OR:
+		emit(code, X86Op::OR, reg(target), reg(other));
+		break;
+	case IrOp::EQ:
+	case IrOp::NE:
+	case IrOp::LT:
+	case IrOp::GT:
+		emit(code, X86Op::CMP, reg(left), reg(right));
+		conditionFlagCode(op == IrOp::EQ ? X86Op::SETE : op == IrOp::NE ? X86Op::SETNE : op == IrOp::LT ? X86Op::SETL : X86Op::SETG, target, code);
+		break;
+	default:
+		throw std::runtime_error("Unsupported binary operator!");
+	}
+}
\ No newline at end of file
@@ -1,34 +1,161 @@
 #ifndef CODE_GENERATOR_H
 #define CODE_GENERATOR_H
 
+#include <exception>
+#include <memory>
 #include <string>
-#include <sstream>
-#include <unordered_map>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 #include "ast.h"
+#include "flat_ast.h"
+#include "diagnostics.h"
+#include "code_sink.h"
+#include "ir.h"
+#include "ir_passes.h"
+#include "string_interner.h"
+#include "thread_pool.h"
+#include "x86.h"
+#include "x86_peephole.h"
 
+// Debugging aids for the IR the code is generated from
+struct IrOptions {
+	bool verify = false; // Check the IR after lowering and after every pass
+	bool dump = false;   // Keep the final IR of every function as text
+};
+
+// Lowers every function to SSA form, runs the IR passes over it and generates MASM x86 from
+// the result. The instructions of a function are collected as a list and go through the
+// peephole optimizer before they are printed.
 class CodeGenerator {
 public:
-	CodeGenerator();
+	// With a pool, the functions of a program are generated in parallel
+	CodeGenerator(const StringInterner& symbols, ThreadPool* pool = nullptr, IrOptions irOptions = IrOptions());
+
+	// Code is appended to out in output order, so it can be written out as it is generated
+	void generateCode(ProgramAST& item, CodeSink& out);
+	void generateCode(FunctionAST& item, CodeSink& out);
+	void generateCode(const FlatAST& ast, CodeSink& out);
+
 	std::string generateCode(ProgramAST& item);
 	std::string generateCode(FunctionAST& item);
-	std::string generateCode(BlockAST& item);
-	std::string generateCode(BlockItemAST& item);
-	std::string generateCode(ConditionAST& item);
-	std::string generateCode(StatementAST& item);
-	std::string generateCode(ExprAST& item);
-	std::string generateCode(DeclarationAST& item);
+	std::string generateCode(const FlatAST& ast);
+
+	// Wraps the code of separately generated functions, named in the same order, into a program
+	std::string programCode(const std::vector<std::string_view>& names, const std::vector<std::string>& functionCodes);
+
+	// Semantic errors; code generated alongside them is not meant to be used
+	const Diagnostics& getDiagnostics() const { return diagnostics; }
+	// The optimized IR of the functions generated so far, in function order, when kept
+	const std::string& getIrDump() const { return irDump; }
+	const IrTimings& getTimings() const { return timings; }
+	const PeepholeStats& getPeepholeStats() const { return peepholeStats; }
+
+	enum class Register : uint8_t { EBX, ECX, ESI, EDI, EAX };
 private:
 	std::string header;
 	std::string functionProtos;
 	std::string dataSection;
-	std::string codeSection;
 
-	int stackIndex;
-	std::vector<std::unordered_map<std::string, int>> varMaps;
+	const StringInterner& symbols;
+	ThreadPool* pool;
+	IrOptions irOptions;
+	IrPassManager passes;
+	std::unordered_set<Symbol> functionNames;
+	Diagnostics diagnostics;
+	std::string irDump;
+	IrTimings timings;
+	PeepholeStats peepholeStats;
+
+	void generateCode(const FlatAST& ast, NodeIndex function, CodeSink& out);
+	// Builds the IR with lower(IrFunction&), optimizes it and emits the function
+	template <class TLower>
+	void functionCode(std::string_view name, TLower lower, CodeSink& out);
+
+	void checkFunctionName(Symbol name, uint32_t offset);
+	void programStart(const std::vector<std::string_view>& names, CodeSink& out);
+	void programEnd(CodeSink& out);
+
+	// State of the function being emitted. A value used once, by an instruction of its own
+	// block or by a phi on an edge out of it, is evaluated as part of that use's expression
+	// tree; other values that need code are computed where they are defined and kept in a
+	// frame slot. Phis are slots written at the end of each predecessor, except a phi that
+	// its block just returns, which the predecessors leave in ebx.
+	std::vector<uint32_t> useCounts;
+	std::vector<bool> inlined;
+	std::vector<int32_t> slots; // Offsets from ebp, 0 for values without a slot
+
+	void emitFunction(const IrFunction& function, X86Code& code);
+	void blockCode(const IrBlock* block, const IrBlock* next, X86Code& code);
+	// Copies the values for the phis of to and jumps there, unless to comes next
+	void edgeCode(const IrBlock* from, const IrBlock* to, const IrBlock* next, X86Code& code);
+	// Evaluates an operand of a terminator or an edge into ebx
+	void operandCode(const IrInstruction* value, X86Code& code);
+
+	// Expression trees are evaluated in registers, allocated by Sethi-Ullman numbering: the
+	// operand needing more registers goes first, and the stack is only used when a subtree
+	// needs more registers than are left. eax and edx are kept free for division and spilled
+	// operands. The IR has no side effects, so operands can go in either order.
+	// Labels of the tree being generated, in pre-order
+	struct ExpressionLabel {
+		uint32_t size;      // Nodes in the subtree
+		uint8_t registers;  // Registers needed to evaluate it without spilling
+	};
+	std::vector<ExpressionLabel> labels;
+	const IrInstruction* expressionRoot;
+
+	// Evaluates the tree of root into ebx
+	void expressionCode(const IrInstruction* root, X86Code& code);
+	bool expanded(const IrInstruction* node) const;
+	void labelExpression(const IrInstruction* node);
+	void allocateExpression(const IrInstruction* node, size_t index, const Register* registers, size_t count, X86Code& code);
+	void leafCode(const IrInstruction* value, Register target, X86Code& code);
+	void unaryCode(IrOp op, Register target, X86Code& code);
+	void binaryCode(IrOp op, Register left, Register right, Register target, X86Code& code);
+	void conditionFlagCode(X86Op set, Register target, X86Code& code);
+
+	// Generates function i with generate(generator, i, out), each function with a fresh
+	// generator so that no state is shared, and appends the code to out in function order.
+	// In parallel the functions are generated into buffers of their own first.
+	template <class TGenerate>
+	void generateFunctions(size_t count, CodeSink& out, TGenerate generate) {
+		if (!pool || count <= 1) {
+			for (size_t i = 0; i < count; i++) {
+				CodeGenerator generator(symbols, nullptr, irOptions);
+				generate(generator, i, out);
+				out << '\n';
+				absorb(generator);
+			}
+			return;
+		}
+
+		std::vector<std::string> codes(count);
+		std::vector<std::unique_ptr<CodeGenerator>> generators(count);
+		std::vector<std::exception_ptr> failures(count);
+		pool->parallelFor(count, [&](size_t i) {
+			try {
+				CodeSink code;
+				generators[i].reset(new CodeGenerator(symbols, nullptr, irOptions));
+				generate(*generators[i], i, code);
+				codes[i] = code.take();
+			}
+			catch (...) {
+				failures[i] = std::current_exception();
+			}
+		});
+
+		for (size_t i = 0; i < count; i++) {
+			if (failures[i]) { std::rethrow_exception(failures[i]); }
+			out << codes[i] << '\n';
+			std::string().swap(codes[i]);
+			absorb(*generators[i]);
+			generators[i].reset();
+		}
+	}
 
-	int findVariableOffset(std::string varName);
+	// Takes over the diagnostics, IR dump, timings and peephole statistics of a function's generator
+	void absorb(const CodeGenerator& generator);
 };
 
 #endif // !CODE_GENERATOR_H
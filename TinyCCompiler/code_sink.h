@@ -0,0 +1,60 @@
+#ifndef CODE_SINK_H
+#define CODE_SINK_H
+
+#include <charconv>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Output of the code generator. Code is appended in output order into one buffer, which is
+// written to the stream (if any) whenever it reaches flushBytes, so every byte is copied once
+// into the buffer and once out of it, and memory stays bounded however large the program is.
+class CodeSink {
+public:
+	// Keeps all code in memory, see take()
+	CodeSink() : stream(nullptr), flushBytes(0), written(0) {};
+	CodeSink(std::ostream& out, size_t _flushBytes = 64 * 1024) : stream(&out), flushBytes(_flushBytes), written(0) {
+		buffer.reserve(flushBytes);
+	};
+	~CodeSink() { flush(); }
+	CodeSink(const CodeSink&) = delete;
+	CodeSink& operator=(const CodeSink&) = delete;
+
+	CodeSink& operator<<(std::string_view text) {
+		buffer.append(text.data(), text.size());
+		if (stream && buffer.size() >= flushBytes) { flush(); }
+		return *this;
+	}
+	CodeSink& operator<<(char c) {
+		buffer.push_back(c);
+		return *this;
+	}
+	CodeSink& operator<<(int32_t value) {
+		char digits[12];
+		auto result = std::to_chars(digits, digits + sizeof(digits), value);
+		return *this << std::string_view(digits, size_t(result.ptr - digits));
+	}
+
+	void flush() {
+		if (!stream || buffer.empty()) { return; }
+		stream->write(buffer.data(), std::streamsize(buffer.size()));
+		written += buffer.size();
+		buffer.clear();
+	}
+
+	// The code collected by a sink without a stream
+	std::string take() {
+		std::string code = std::move(buffer);
+		buffer.clear();
+		return code;
+	}
+	uint64_t size() const { return written + buffer.size(); }
+private:
+	std::ostream* stream;
+	size_t flushBytes;
+	uint64_t written;
+	std::string buffer;
+};
+
+#endif
\ No newline at end of file
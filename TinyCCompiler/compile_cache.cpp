@@ -0,0 +1,154 @@
+#include "compile_cache.h"
+#include "hash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const char* const ENTRY_EXTENSION = ".asm";
+
+static int64_t now() {
+	return fs::file_time_type::clock::now().time_since_epoch().count();
+}
+
+CompileCache::CompileCache(const std::string& _directory, uint64_t _maxBytes) : directory(_directory), maxBytes(_maxBytes), totalBytes(0) {}
+
+bool CompileCache::open() {
+	std::error_code error;
+	fs::create_directories(directory, error);
+	if (!fs::is_directory(directory, error)) { return false; }
+
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	totalBytes = 0;
+	for (auto& file : fs::directory_iterator(directory, error)) {
+		if (file.path().extension() != ENTRY_EXTENSION) { continue; }
+
+		uint64_t bytes = file.file_size(error);
+		if (error) { continue; }
+		entries[file.path().stem().string()] = { bytes, file.last_write_time(error).time_since_epoch().count() };
+		totalBytes += bytes;
+	}
+	return true;
+}
+
+std::string CompileCache::key(std::string_view source, const CompileOptions& options) const {
+	std::string salt = std::string(COMPILER_VERSION) + '\0' + std::to_string(encodeOptions(options));
+	uint64_t seed = xxHash64(salt);
+	uint64_t halves[2] = { xxHash64(source, seed), xxHash64(source, ~seed) };
+
+	static const char digits[] = "0123456789abcdef";
+	std::string key;
+	for (uint64_t half : halves) {
+		for (int shift = 60; shift >= 0; shift -= 4) {
+			key += digits[(half >> shift) & 0xF];
+		}
+	}
+	return key;
+}
+
+std::string CompileCache::entryPath(const std::string& key) const {
+	return (fs::path(directory) / (key + ENTRY_EXTENSION)).string();
+}
+
+bool CompileCache::lookup(const std::string& key, std::string& code) {
+	std::string path = entryPath(key);
+	std::ifstream in(path, std::ifstream::binary);
+	if (!in.is_open()) {
+		std::lock_guard<std::mutex> lock(mutex);
+		counts.misses++;
+		return false;
+	}
+	code.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	in.close();
+
+	// Touching the file keeps the entry alive for other processes sharing the cache as well
+	std::error_code error;
+	fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	counts.hits++;
+	auto found = entries.find(key);
+	if (found == entries.end()) {
+		// Written by another process since the cache was opened
+		entries[key] = { code.size(), now() };
+		totalBytes += code.size();
+	}
+	else {
+		found->second.lastUse = now();
+	}
+	return true;
+}
+
+void CompileCache::store(const std::string& key, const std::string& code) {
+	std::string path = entryPath(key);
+	std::string temporaryPath = path + "." + std::to_string(std::random_device()()) + ".tmp";
+	{
+		std::ofstream out(temporaryPath, std::ofstream::binary);
+		if (!out.is_open()) { return; }
+		out << code;
+		if (!out.flush()) {
+			out.close();
+			std::remove(temporaryPath.c_str());
+			return;
+		}
+	}
+
+	std::error_code error;
+	fs::rename(temporaryPath, path, error);
+	if (error) {
+		fs::remove(temporaryPath, error);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	counts.stores++;
+	Entry& entry = entries[key];
+	totalBytes += code.size() - entry.bytes;
+	entry = { code.size(), now() };
+	if (totalBytes > maxBytes) { evict(); }
+}
+
+// Removes the least recently used entries until the cache is below 90% of its bound,
+// so that a full cache doesn't evict on every store. Called with the mutex held.
+void CompileCache::evict() {
+	std::vector<std::pair<int64_t, std::string>> byAge;
+	byAge.reserve(entries.size());
+	for (auto& entry : entries) {
+		byAge.emplace_back(entry.second.lastUse, entry.first);
+	}
+	std::sort(byAge.begin(), byAge.end());
+
+	uint64_t target = maxBytes / 10 * 9;
+	for (auto& old : byAge) {
+		if (totalBytes <= target) { break; }
+
+		std::error_code error;
+		fs::remove(entryPath(old.second), error);
+		totalBytes -= entries[old.second].bytes;
+		entries.erase(old.second);
+		counts.evictions++;
+	}
+}
+
+CompileCache::Statistics CompileCache::statistics() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counts;
+}
+
+void CompileCache::printStatistics(std::ostream& out) {
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t lookups = counts.hits + counts.misses;
+	out << "Cache: " << counts.hits << " hits, " << counts.misses << " misses";
+	if (lookups > 0) {
+		out << " (" << 100.0 * counts.hits / lookups << "% hit rate)";
+	}
+	out << ", " << counts.stores << " stores, " << counts.evictions << " evictions, "
+		<< entries.size() << " entries, " << totalBytes << " of " << maxBytes << " bytes" << std::endl;
+}
\ No newline at end of file
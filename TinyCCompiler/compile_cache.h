@@ -0,0 +1,56 @@
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include "compiler.h"
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// On-disk cache of generated assembly, one file per entry named by a 128-bit hash of the
+// source, COMPILER_VERSION and the options. Entries are written to a temporary file and
+// renamed, so concurrent compilers never see a partial entry. Reading an entry marks it as
+// recently used; when the cache grows past its size bound the least recently used entries
+// are removed. All methods may be called from several threads.
+class CompileCache {
+public:
+	struct Statistics {
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t stores = 0;
+		size_t evictions = 0;
+	};
+
+	CompileCache(const std::string& directory, uint64_t maxBytes);
+
+	// Returns false when the cache directory can't be created
+	bool open();
+
+	std::string key(std::string_view source, const CompileOptions& options) const;
+	bool lookup(const std::string& key, std::string& code);
+	void store(const std::string& key, const std::string& code);
+
+	Statistics statistics();
+	void printStatistics(std::ostream& out);
+private:
+	struct Entry {
+		uint64_t bytes;
+		int64_t lastUse;    // Modification time of the file, which is what other processes see
+	};
+
+	std::string directory;
+	uint64_t maxBytes;
+
+	std::mutex mutex;
+	std::unordered_map<std::string, Entry> entries;
+	uint64_t totalBytes;
+	Statistics counts;
+
+	std::string entryPath(const std::string& key) const;
+	void evict();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,316 @@
+#include "compile_server.h"
+#include "source_file.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "ws2_32.lib")
+
+typedef SOCKET SocketHandle;
+static const SocketHandle NO_SOCKET = INVALID_SOCKET;
+
+static bool startSockets() {
+	WSADATA data;
+	return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+}
+
+static void closeSocket(SocketHandle socket) {
+	closesocket(socket);
+}
+
+// 0 when nothing is at the path, 1 for a socket file and -1 for anything else
+static int socketFileKind(const std::string& path) {
+	DWORD attributes = GetFileAttributesA(path.c_str());
+	if (attributes == INVALID_FILE_ATTRIBUTES) { return 0; }
+	// Unix domain sockets are reparse points on Windows
+	return (attributes & FILE_ATTRIBUTE_REPARSE_POINT) && !(attributes & FILE_ATTRIBUTE_DIRECTORY) ? 1 : -1;
+}
+#else
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+typedef int SocketHandle;
+static const SocketHandle NO_SOCKET = -1;
+
+static bool startSockets() {
+	return true;
+}
+
+static void closeSocket(SocketHandle socket) {
+	close(socket);
+}
+
+// 0 when nothing is at the path, 1 for a socket file and -1 for anything else
+static int socketFileKind(const std::string& path) {
+	struct stat status;
+	if (lstat(path.c_str(), &status) != 0) { return 0; }
+	return S_ISSOCK(status.st_mode) ? 1 : -1;
+}
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// A request is a RequestHeader followed by the source, a response a ResponseHeader followed
+// by the assembly and the diagnostics text. Both ends are on the same machine, so the
+// fields are in host byte order.
+struct RequestHeader {
+	uint32_t options;
+	uint32_t sourceBytes;
+};
+
+struct ResponseHeader {
+	int32_t status;
+	uint32_t codeBytes;
+	uint32_t messageBytes;
+};
+
+// Larger requests are taken for garbage and close the connection
+static const uint32_t MAX_SOURCE_BYTES = 256 << 20;
+
+static bool sendAll(SocketHandle socket, const void* data, size_t size) {
+	const char* bytes = static_cast<const char*>(data);
+	while (size > 0) {
+		auto sent = send(socket, bytes, int(size), MSG_NOSIGNAL);
+		if (sent <= 0) { return false; }
+		bytes += sent;
+		size -= size_t(sent);
+	}
+	return true;
+}
+
+static bool receiveAll(SocketHandle socket, void* data, size_t size) {
+	char* bytes = static_cast<char*>(data);
+	while (size > 0) {
+		auto received = recv(socket, bytes, int(size), 0);
+		if (received <= 0) { return false; }
+		bytes += received;
+		size -= size_t(received);
+	}
+	return true;
+}
+
+static bool makeAddress(const std::string& socketPath, sockaddr_un& address, std::ostream& out) {
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketPath.size() >= sizeof(address.sun_path)) {
+		out << "Socket path is too long!" << std::endl;
+		return false;
+	}
+	std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+	return true;
+}
+
+static bool serverListens(const sockaddr_un& address) {
+	SocketHandle probe = socket(AF_UNIX, SOCK_STREAM, 0);
+	bool answered = probe != NO_SOCKET && connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+	if (probe != NO_SOCKET) { closeSocket(probe); }
+	return answered;
+}
+
+// bind needs the path to be free. Only a socket file left by a server that is gone is removed;
+// other files and the socket of a running server are left alone.
+static bool claimSocketPath(const std::string& socketPath, const sockaddr_un& address, std::ostream& out) {
+	int kind = socketFileKind(socketPath);
+	if (kind == 0) { return true; }
+	if (kind < 0) {
+		out << socketPath << " exists and is not a socket!" << std::endl;
+		return false;
+	}
+
+	if (serverListens(address)) {
+		out << "A server is already listening on " << socketPath << "!" << std::endl;
+		return false;
+	}
+	std::remove(socketPath.c_str());
+	return true;
+}
+
+// Answers requests until the client disconnects or sends something malformed.
+// The buffers are kept across requests, so a warm connection doesn't reallocate them.
+static void serveConnection(SocketHandle client) {
+	std::string source;
+	std::string code;
+	std::ostringstream messages;
+
+	RequestHeader request;
+	while (receiveAll(client, &request, sizeof(request)) && request.sourceBytes <= MAX_SOURCE_BYTES) {
+		source.resize(request.sourceBytes);
+		if (!receiveAll(client, &source[0], source.size())) { return; }
+
+		code.clear();
+		messages.str(std::string());
+		ResponseHeader response;
+		try {
+			response.status = compileSource(source, decodeOptions(request.options), code, messages);
+		}
+		catch (const std::exception& err) {
+			messages << err.what() << std::endl;
+			response.status = 1;
+		}
+		if (response.status != 0) { code.clear(); }
+
+		std::string text = messages.str();
+		response.codeBytes = uint32_t(code.size());
+		response.messageBytes = uint32_t(text.size());
+		if (!sendAll(client, &response, sizeof(response))
+			|| !sendAll(client, code.data(), code.size())
+			|| !sendAll(client, text.data(), text.size())) {
+			return;
+		}
+	}
+}
+
+int runServer(const std::string& socketPath, std::ostream& out) {
+	sockaddr_un address;
+	if (!makeAddress(socketPath, address, out)) { return -1; }
+	if (!startSockets()) {
+		out << "Sockets are not available!" << std::endl;
+		return -1;
+	}
+
+	SocketHandle listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener == NO_SOCKET) {
+		out << "Can't create the server socket!" << std::endl;
+		return -1;
+	}
+
+	if (!claimSocketPath(socketPath, address, out)) {
+		closeSocket(listener);
+		return -1;
+	}
+	if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+		out << "Can't listen on " << socketPath << "!" << std::endl;
+		closeSocket(listener);
+		return -1;
+	}
+	out << "Listening on " << socketPath << std::endl;
+
+	while (true) {
+		SocketHandle client = accept(listener, nullptr, nullptr);
+		if (client == NO_SOCKET) { continue; }
+
+		std::thread([client] {
+			serveConnection(client);
+			closeSocket(client);
+		}).detach();
+	}
+}
+
+// Sends one request and waits for the answer. Returns false when the server can't be reached
+// or closes the connection before answering.
+static bool requestCompile(const sockaddr_un& address, std::string_view source, const CompileOptions& options, ResponseHeader& response, std::string& code, std::string& messages, std::ostream& out) {
+	SocketHandle server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server == NO_SOCKET || connect(server, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+		out << "Can't connect to the server at " << address.sun_path << "!" << std::endl;
+		if (server != NO_SOCKET) { closeSocket(server); }
+		return false;
+	}
+
+	RequestHeader request;
+	request.options = encodeOptions(options);
+	request.sourceBytes = uint32_t(source.size());
+
+	bool answered = sendAll(server, &request, sizeof(request))
+		&& sendAll(server, source.data(), source.size())
+		&& receiveAll(server, &response, sizeof(response));
+	if (answered) {
+		code.resize(response.codeBytes);
+		messages.resize(response.messageBytes);
+		answered = receiveAll(server, &code[0], code.size()) && receiveAll(server, &messages[0], messages.size());
+	}
+	closeSocket(server);
+
+	if (!answered) {
+		out << "The server closed the connection!" << std::endl;
+	}
+	return answered;
+}
+
+int runClient(const std::string& socketPath, const std::string& filename, const std::string& outputFile, const CompileOptions& options, std::ostream& out) {
+	SourceFile input;
+	if (!input.open(filename)) {
+		out << "Wrong input filename!" << std::endl;
+		return -1;
+	}
+	std::string_view source = input.contents();
+	if (source.size() > MAX_SOURCE_BYTES) {
+		out << "Input file is too large for the server!" << std::endl;
+		return -1;
+	}
+
+	sockaddr_un address;
+	if (!makeAddress(socketPath, address, out) || !startSockets()) { return -1; }
+
+	ResponseHeader response;
+	std::string code;
+	std::string messages;
+	if (!requestCompile(address, source, options, response, code, messages, out)) { return -1; }
+
+	out << messages;
+	if (response.status == 0 && !writeOutputFile(outputFile, code, out)) { return -1; }
+	return response.status;
+}
+
+int runServerCheck(const std::string& socketPath, std::ostream& out) {
+	sockaddr_un address;
+	if (!makeAddress(socketPath, address, out) || !startSockets()) { return -1; }
+
+	// The server runs until the process exits
+	std::thread([socketPath, &out] { runServer(socketPath, out); }).detach();
+	for (int attempt = 0; !serverListens(address); attempt++) {
+		if (attempt == 500) {
+			out << "The server didn't start!" << std::endl;
+			return -1;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	// Missing operands that once left null children in the tree and crashed the server
+	const char* const malformed[] = {
+		"int main(){int v=1; return (+v);}",
+		"int main(){return (&&1);}",
+		"int main(){int a = (*1) + (2); return a;}",
+		"int main(){int v=1; v = (+v = 1); return v;}",
+	};
+	const char* const valid = "int main(){int v=2; return (v + 1) * 3 - !v;}";
+
+	ResponseHeader response;
+	std::string code;
+	std::string messages;
+	for (ExpressionParsing parsing : { ExpressionParsing::PRECEDENCE_CLIMBING, ExpressionParsing::RECURSIVE_DESCENT }) {
+		CompileOptions options;
+		options.expressionParsing = parsing;
+		for (const char* source : malformed) {
+			if (!requestCompile(address, source, options, response, code, messages, out)) { return -1; }
+			if (response.status == 0) {
+				out << "The server compiled the malformed program " << source << std::endl;
+				return -1;
+			}
+		}
+
+		// Whatever the malformed requests did, the server has to go on compiling
+		if (!requestCompile(address, valid, options, response, code, messages, out)) { return -1; }
+		if (response.status != 0 || code.empty()) {
+			out << "The server failed to compile " << valid << std::endl << messages;
+			return -1;
+		}
+	}
+
+	std::remove(socketPath.c_str());
+	out << "Server rejected " << 2 * std::size(malformed) << " malformed programs and still compiles" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef COMPILE_SERVER_H
+#define COMPILE_SERVER_H
+
+#include "compiler.h"
+
+#include <ostream>
+#include <string>
+
+// Keeps the compiler resident and answers compile requests on a local Unix domain
+// socket. Every connection is served by its own thread and may send any number of
+// requests. Only returns when the socket can't be set up.
+int runServer(const std::string& socketPath, std::ostream& out);
+
+// Sends the file to a running server and writes the returned assembly to outputFile.
+// Diagnostics are printed to out; returns the status the server compiled the file with.
+int runClient(const std::string& socketPath, const std::string& filename, const std::string& outputFile, const CompileOptions& options, std::ostream& out);
+
+// Starts a server on socketPath in this process and sends it malformed programs that once
+// crashed it, then a valid one that must still compile. Returns 0 when all were answered.
+int runServerCheck(const std::string& socketPath, std::ostream& out);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "compiler.h"
+#include "compile_cache.h"
+#include "lexer.h"
+#include "dfa_lexer.h"
+#include "code_generator.h"
+#include "source_file.h"
+
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+static const uint32_t OPTION_LEGACY_LEXER = 1;
+static const uint32_t OPTION_STREAMING = 2;
+static const uint32_t OPTION_FLAT_AST = 4;
+static const uint32_t OPTION_RECURSIVE_EXPRESSIONS = 8;
+
+uint32_t encodeOptions(const CompileOptions& options) {
+	return (options.legacyLexer ? OPTION_LEGACY_LEXER : 0)
+		| (options.streaming ? OPTION_STREAMING : 0)
+		| (options.flatAst ? OPTION_FLAT_AST : 0)
+		| (options.expressionParsing == ExpressionParsing::RECURSIVE_DESCENT ? OPTION_RECURSIVE_EXPRESSIONS : 0);
+}
+
+CompileOptions decodeOptions(uint32_t bits) {
+	CompileOptions options;
+	options.legacyLexer = (bits & OPTION_LEGACY_LEXER) != 0;
+	options.streaming = (bits & OPTION_STREAMING) != 0;
+	options.flatAst = (bits & OPTION_FLAT_AST) != 0;
+	if (bits & OPTION_RECURSIVE_EXPRESSIONS) {
+		options.expressionParsing = ExpressionParsing::RECURSIVE_DESCENT;
+	}
+	return options;
+}
+
+// Parses with the given parser; tree maps the parse result to what CodeGenerator takes.
+template <class TParser, class TTree>
+static int compileWith(TokenSource& tokens, TParser& parser, TTree tree, const StringInterner& symbols, ThreadPool* pool, const CompileOptions& options, CodeSink& code, std::ostream& out) {
+	auto ast = parser.Parse();
+	Diagnostics diagnostics = parser.GetDiagnostics();
+
+	if (ast) {
+		IrOptions irOptions;
+		irOptions.verify = options.verifyIr;
+		irOptions.dump = options.dumpIr;
+		CodeGenerator codeGen(symbols, pool, irOptions);
+		try {
+			codeGen.generateCode(tree(ast), code);
+		}
+		catch (const std::runtime_error& err) {
+			out << err.what() << std::endl;
+			return 1;
+		}
+		diagnostics.append(codeGen.getDiagnostics());
+		out << codeGen.getIrDump();
+		if (options.timePasses) {
+			codeGen.getTimings().print(out);
+		}
+		if (options.peepholeStats) {
+			codeGen.getPeepholeStats().print(out);
+		}
+	}
+
+	diagnostics.print(out, tokens);
+	return diagnostics.empty() ? 0 : 1;
+}
+
+int compile(TokenSource& tokens, const StringInterner& symbols, ThreadPool* pool, const CompileOptions& options, CodeSink& code, std::ostream& out) {
+	if (options.flatAst) {
+		FlatAST ast;
+		FlatParser parser(tokens, ast, options.expressionParsing);
+		return compileWith(tokens, parser, [&](FlatNode) -> const FlatAST& { return ast; }, symbols, pool, options, code, out);
+	}
+
+	AstArena arena;
+	Parser parser(tokens, arena, options.expressionParsing);
+	return compileWith(tokens, parser, [](ProgramAST* program) -> ProgramAST& { return *program; }, symbols, pool, options, code, out);
+}
+
+int compile(TokenSource& tokens, const StringInterner& symbols, ThreadPool* pool, const CompileOptions& options, std::string& code, std::ostream& out) {
+	CodeSink sink;
+	int status = compile(tokens, symbols, pool, options, sink, out);
+	code = sink.take();
+	return status;
+}
+
+int compile(TokenSource& tokens, const StringInterner& symbols, ThreadPool* pool, const std::string& outputFile, const CompileOptions& options, std::ostream& out) {
+	// The code is written to a temporary file as it is generated, which becomes the output
+	// only when there are no errors
+	std::string temporaryFile = outputFile + ".tmp";
+	int status;
+	{
+		std::ofstream file(temporaryFile);
+		if (!file.is_open()) {
+			out << "Wrong output filename!" << std::endl;
+			return -1;
+		}
+		CodeSink code(file);
+		status = compile(tokens, symbols, pool, options, code, out);
+		code.flush();
+		if (status == 0 && !file.flush()) { status = -1; }
+	}
+
+	std::error_code error;
+	if (status == 0) {
+		std::filesystem::rename(temporaryFile, outputFile, error);
+	}
+	if (status != 0 || error) {
+		std::filesystem::remove(temporaryFile, error);
+	}
+	if (status == -1 || error) {
+		out << "Wrong output filename!" << std::endl;
+		return -1;
+	}
+	return status;
+}
+
+template <class TLexer>
+static int compileSourceWith(std::string_view source, const CompileOptions& options, std::string& code, std::ostream& out) {
+	StringInterner symbols;
+	TLexer lexer(source, &symbols);
+	if (options.streaming) {
+		TokenWindow<TLexer> tokens(lexer, source);
+		return compile(tokens, symbols, nullptr, options, code, out);
+	}
+
+	TokenStream tokens(source);
+	CompactToken token;
+	do {
+		token = lexer.getNextToken();
+		tokens.push_back(token);
+	} while (token.type != TokenType::End);
+	return compile(tokens, symbols, nullptr, options, code, out);
+}
+
+int compileSource(std::string_view source, const CompileOptions& options, std::string& code, std::ostream& out) {
+	if (options.legacyLexer) {
+		return compileSourceWith<Lexer>(source, options, code, out);
+	}
+	return compileSourceWith<DfaLexer>(source, options, code, out);
+}
+
+bool writeOutputFile(const std::string& outputFile, const std::string& code, std::ostream& out) {
+	std::ofstream file(outputFile);
+	if (!file.is_open()) {
+		out << "Wrong output filename!" << std::endl;
+		return false;
+	}
+	file << code;
+	return true;
+}
+
+bool readResponseFile(const std::string& filename, std::vector<std::string>& files) {
+	std::ifstream in(filename);
+	if (!in.is_open()) { return false; }
+
+	std::string file;
+	while (in >> file) {
+		files.push_back(file);
+	}
+	return true;
+}
+
+struct BatchResult {
+	int status = 0;
+	size_t sourceBytes = 0;
+	std::string messages;
+};
+
+int compileBatch(const std::vector<std::string>& files, const CompileOptions& options, size_t jobs, CompileCache* cache, std::ostream& out) {
+	std::vector<BatchResult> results(files.size());
+	auto start = std::chrono::steady_clock::now();
+
+	{
+		ThreadPool pool(jobs);
+		// Jobs only run serial code generation, since a task can't wait for the pool it runs on
+		pool.parallelFor(files.size(), [&](size_t i) {
+			BatchResult& result = results[i];
+			std::ostringstream messages;
+			try {
+				SourceFile input;
+				if (!input.open(files[i])) {
+					messages << "Wrong input filename!" << std::endl;
+					result.status = -1;
+				}
+				else {
+					std::string outputFile = std::filesystem::path(files[i]).replace_extension(".asm").string();
+					std::string code;
+					result.sourceBytes = input.contents().size();
+
+					std::string cacheKey;
+					if (cache) { cacheKey = cache->key(input.contents(), options); }
+					if (!cache || !cache->lookup(cacheKey, code)) {
+						result.status = compileSource(input.contents(), options, code, messages);
+						if (cache && result.status == 0) { cache->store(cacheKey, code); }
+					}
+					if (result.status == 0 && !writeOutputFile(outputFile, code, messages)) { result.status = -1; }
+				}
+			}
+			catch (const std::exception& err) {
+				messages << err.what() << std::endl;
+				result.status = 1;
+			}
+			result.messages = messages.str();
+		});
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	size_t failed = 0;
+	size_t sourceBytes = 0;
+	for (size_t i = 0; i < files.size(); i++) {
+		const BatchResult& result = results[i];
+		sourceBytes += result.sourceBytes;
+		if (result.status != 0) { failed++; }
+		if (!result.messages.empty()) {
+			out << files[i] << ":" << std::endl << result.messages;
+		}
+	}
+
+	out << "Compiled " << files.size() - failed << " of " << files.size() << " files ("
+		<< sourceBytes << " bytes) in " << seconds << " s on " << jobs << " threads: "
+		<< files.size() / seconds << " files/s, " << double(sourceBytes) / (1024 * 1024) / seconds << " MB/s" << std::endl;
+	return failed == 0 ? 0 : 1;
+}
\ No newline at end of file
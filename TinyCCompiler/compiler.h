@@ -0,0 +1,63 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "parser.h"
+#include "code_sink.h"
+#include "string_interner.h"
+#include "thread_pool.h"
+#include "token_stream.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct CompileOptions {
+	bool legacyLexer = false;
+	bool streaming = false;    // Pull tokens as the parser goes instead of lexing the whole file first
+	bool flatAst = false;
+	ExpressionParsing expressionParsing = ExpressionParsing::PRECEDENCE_CLIMBING;
+
+	// Debugging aids that don't change the code, so they are not part of the encoded options
+	bool verifyIr = false;      // Check the IR after lowering and after every pass
+	bool dumpIr = false;        // Print the optimized IR of every function
+	bool timePasses = false;    // Print the time spent in each stage of the IR pipeline
+	bool peepholeStats = false; // Print how often each peephole rule applied
+};
+
+// Names the code generation; change it whenever the same source compiles to different
+// assembly, so cached results of older compilers are not used.
+const char* const COMPILER_VERSION = "TinyCCompiler 1.26";
+
+// Options as bits, for requests to the compile server and cache keys
+uint32_t encodeOptions(const CompileOptions& options);
+CompileOptions decodeOptions(uint32_t bits);
+
+// Parses the tokens and generates the assembly into code. Syntax and semantic errors are
+// all printed to out. Returns 0 on success and 1 on errors, when code is not meant to be used.
+int compile(TokenSource& tokens, const StringInterner& symbols, ThreadPool* pool, const CompileOptions& options, CodeSink& code, std::ostream& out);
+int compile(TokenSource& tokens, const StringInterner& symbols, ThreadPool* pool, const CompileOptions& options, std::string& code, std::ostream& out);
+
+// As above, but streams the assembly into outputFile, which is only replaced when there are
+// no errors. Returns -1 when the output file can't be written.
+int compile(TokenSource& tokens, const StringInterner& symbols, ThreadPool* pool, const std::string& outputFile, const CompileOptions& options, std::ostream& out);
+
+// Lexes and compiles the source on the calling thread, without printing the tokens.
+int compileSource(std::string_view source, const CompileOptions& options, std::string& code, std::ostream& out);
+
+// Reports "Wrong output filename!" to out when the file can't be written.
+bool writeOutputFile(const std::string& outputFile, const std::string& code, std::ostream& out);
+
+// Adds the whitespace-separated file names listed in a response file. Returns false when it can't be read.
+bool readResponseFile(const std::string& filename, std::vector<std::string>& files);
+
+class CompileCache;
+
+// Compiles every file into the same path with an .asm extension. Each file is one job on a
+// work-stealing pool and owns its lexer, parser and code generator; files found in the cache
+// (if any) are not compiled. Diagnostics are printed per file in input order, followed by the
+// total throughput. Returns 0 when all files compiled.
+int compileBatch(const std::vector<std::string>& files, const CompileOptions& options, size_t jobs, CompileCache* cache, std::ostream& out);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "dfa_lexer.h"
+#include "keywords.h"
+#include "simd_scan.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+
+enum CharClass : uint8_t {
+	CC_OTHER,
+	CC_SPACE,
+	CC_LETTER,
+	CC_LETTER_B,
+	CC_UNDERSCORE,
+	CC_ZERO,
+	CC_ONE,
+	CC_DIGIT,
+	CC_DOT,
+	CC_OPEN_PARENTHESE,
+	CC_CLOSE_PARENTHESE,
+	CC_OPEN_BRACE,
+	CC_CLOSE_BRACE,
+	CC_SEMICOLON,
+	CC_TILDE,
+	CC_MINUS,
+	CC_BANG,
+	CC_PLUS,
+	CC_STAR,
+	CC_SLASH,
+	CC_LESS,
+	CC_GREATER,
+	CC_AMPERSAND,
+	CC_PIPE,
+	CC_EQUALS,
+	CC_EOF,
+	CC_COUNT
+};
+
+enum State : uint8_t {
+	S_START,
+	S_IDENTIFIER,
+	S_ZERO,         // "0": may continue as float, binary or decimal
+	S_ZERO_ZERO,    // "00...": decimal only, the legacy lexer never reads it as a float
+	S_ZERO_B,       // "0b" without digits yet
+	S_BINARY,
+	S_DECIMAL,      // becomes a float on '.'
+	S_FLOAT,
+	S_AMPERSAND,
+	S_PIPE,
+	S_EQUALS,
+
+	// States below are final: the character that enters them is consumed and the token ends
+	S_FIRST_FINAL,
+	S_OPEN_PARENTHESE = S_FIRST_FINAL,
+	S_CLOSE_PARENTHESE,
+	S_OPEN_BRACE,
+	S_CLOSE_BRACE,
+	S_SEMICOLON,
+	S_TILDE,
+	S_MINUS,
+	S_BANG,
+	S_PLUS,
+	S_STAR,
+	S_SLASH,
+	S_LESS,
+	S_GREATER,
+	S_LOGICAL_AND,
+	S_LOGICAL_OR,
+	S_EQUAL,
+	S_ERROR,
+	S_END,
+
+	S_COUNT,
+	S_DONE = S_COUNT // Token ends before the current character
+};
+
+struct Accept {
+	TokenType type;
+	uint8_t backtrack; // Characters to give back when the token ends in this state
+};
+
+constexpr std::array<uint8_t, 256> makeCharClasses() {
+	std::array<uint8_t, 256> classes{};
+	for (int c = 'a'; c <= 'z'; c++) { classes[c] = CC_LETTER; }
+	for (int c = 'A'; c <= 'Z'; c++) { classes[c] = CC_LETTER; }
+	for (int c = '2'; c <= '9'; c++) { classes[c] = CC_DIGIT; }
+	classes['b'] = CC_LETTER_B;
+	classes['_'] = CC_UNDERSCORE;
+	classes['0'] = CC_ZERO;
+	classes['1'] = CC_ONE;
+	classes['.'] = CC_DOT;
+	classes[' '] = CC_SPACE;
+	classes['\n'] = CC_SPACE;
+	classes['\r'] = CC_SPACE;
+	classes['\t'] = CC_SPACE;
+	classes['('] = CC_OPEN_PARENTHESE;
+	classes[')'] = CC_CLOSE_PARENTHESE;
+	classes['{'] = CC_OPEN_BRACE;
+	classes['}'] = CC_CLOSE_BRACE;
+	classes[';'] = CC_SEMICOLON;
+	classes['~'] = CC_TILDE;
+	classes['-'] = CC_MINUS;
+	classes['!'] = CC_BANG;
+	classes['+'] = CC_PLUS;
+	classes['*'] = CC_STAR;
+	classes['/'] = CC_SLASH;
+	classes['<'] = CC_LESS;
+	classes['>'] = CC_GREATER;
+	classes['&'] = CC_AMPERSAND;
+	classes['|'] = CC_PIPE;
+	classes['='] = CC_EQUALS;
+	return classes;
+}
+
+constexpr std::array<std::array<uint8_t, CC_COUNT>, S_COUNT> makeTransitions() {
+	std::array<std::array<uint8_t, CC_COUNT>, S_COUNT> table{};
+	for (auto& row : table) {
+		for (auto& next : row) { next = S_DONE; }
+	}
+
+	auto& start = table[S_START];
+	for (auto& next : start) { next = S_ERROR; }
+	start[CC_SPACE] = S_START;
+	start[CC_LETTER] = S_IDENTIFIER;
+	start[CC_LETTER_B] = S_IDENTIFIER;
+	start[CC_ZERO] = S_ZERO;
+	start[CC_ONE] = S_DECIMAL;
+	start[CC_DIGIT] = S_DECIMAL;
+	start[CC_OPEN_PARENTHESE] = S_OPEN_PARENTHESE;
+	start[CC_CLOSE_PARENTHESE] = S_CLOSE_PARENTHESE;
+	start[CC_OPEN_BRACE] = S_OPEN_BRACE;
+	start[CC_CLOSE_BRACE] = S_CLOSE_BRACE;
+	start[CC_SEMICOLON] = S_SEMICOLON;
+	start[CC_TILDE] = S_TILDE;
+	start[CC_MINUS] = S_MINUS;
+	start[CC_BANG] = S_BANG;
+	start[CC_PLUS] = S_PLUS;
+	start[CC_STAR] = S_STAR;
+	start[CC_SLASH] = S_SLASH;
+	start[CC_LESS] = S_LESS;
+	start[CC_GREATER] = S_GREATER;
+	start[CC_AMPERSAND] = S_AMPERSAND;
+	start[CC_PIPE] = S_PIPE;
+	start[CC_EQUALS] = S_EQUALS;
+	start[CC_EOF] = S_END;
+
+	for (uint8_t cc : { CC_LETTER, CC_LETTER_B, CC_UNDERSCORE, CC_ZERO, CC_ONE, CC_DIGIT }) {
+		table[S_IDENTIFIER][cc] = S_IDENTIFIER;
+	}
+
+	table[S_ZERO][CC_ZERO] = S_ZERO_ZERO;
+	table[S_ZERO][CC_ONE] = S_DECIMAL;
+	table[S_ZERO][CC_DIGIT] = S_DECIMAL;
+	table[S_ZERO][CC_DOT] = S_FLOAT;
+	table[S_ZERO][CC_LETTER_B] = S_ZERO_B;
+
+	for (uint8_t cc : { CC_ZERO, CC_ONE, CC_DIGIT }) {
+		table[S_ZERO_ZERO][cc] = S_ZERO_ZERO;
+		table[S_DECIMAL][cc] = S_DECIMAL;
+		table[S_FLOAT][cc] = S_FLOAT;
+	}
+	table[S_DECIMAL][CC_DOT] = S_FLOAT;
+	table[S_FLOAT][CC_DOT] = S_FLOAT;
+
+	for (uint8_t cc : { CC_ZERO, CC_ONE }) {
+		table[S_ZERO_B][cc] = S_BINARY;
+		table[S_BINARY][cc] = S_BINARY;
+	}
+
+	table[S_AMPERSAND][CC_AMPERSAND] = S_LOGICAL_AND;
+	table[S_PIPE][CC_PIPE] = S_LOGICAL_OR;
+	table[S_EQUALS][CC_EQUALS] = S_EQUAL;
+	return table;
+}
+
+constexpr std::array<Accept, S_COUNT> makeAccepts() {
+	std::array<Accept, S_COUNT> accepts{};
+	for (auto& accept : accepts) { accept = { TokenType::FAILED, 0 }; }
+
+	accepts[S_IDENTIFIER] = { TokenType::Identifier, 0 };
+	accepts[S_ZERO] = { TokenType::IntValue, 0 };
+	accepts[S_ZERO_ZERO] = { TokenType::IntValue, 0 };
+	accepts[S_ZERO_B] = { TokenType::IntValue, 1 };
+	accepts[S_BINARY] = { TokenType::IntValue, 0 };
+	accepts[S_DECIMAL] = { TokenType::IntValue, 0 };
+	accepts[S_FLOAT] = { TokenType::FloatValue, 0 };
+	accepts[S_EQUALS] = { TokenType::Assignment, 0 };
+	accepts[S_OPEN_PARENTHESE] = { TokenType::OpenParenthese, 0 };
+	accepts[S_CLOSE_PARENTHESE] = { TokenType::CloseParenthese, 0 };
+	accepts[S_OPEN_BRACE] = { TokenType::OpenBrace, 0 };
+	accepts[S_CLOSE_BRACE] = { TokenType::CloseBrace, 0 };
+	accepts[S_SEMICOLON] = { TokenType::Semicolon, 0 };
+	accepts[S_TILDE] = { TokenType::BitwiseComplement, 0 };
+	accepts[S_MINUS] = { TokenType::Negation, 0 };
+	accepts[S_BANG] = { TokenType::LogicalNegation, 0 };
+	accepts[S_PLUS] = { TokenType::Addition, 0 };
+	accepts[S_STAR] = { TokenType::Multiplication, 0 };
+	accepts[S_SLASH] = { TokenType::Division, 0 };
+	accepts[S_LESS] = { TokenType::Less, 0 };
+	accepts[S_GREATER] = { TokenType::Greater, 0 };
+	accepts[S_LOGICAL_AND] = { TokenType::LogicalAnd, 0 };
+	accepts[S_LOGICAL_OR] = { TokenType::LogicalOr, 0 };
+	accepts[S_EQUAL] = { TokenType::Equal, 0 };
+	accepts[S_END] = { TokenType::End, 0 };
+	return accepts;
+}
+
+// Radix applied to the literal value when a digit moves the automaton into a state
+constexpr std::array<uint8_t, S_COUNT> makeRadixes() {
+	std::array<uint8_t, S_COUNT> radixes{};
+	radixes[S_ZERO] = 10;
+	radixes[S_ZERO_ZERO] = 10;
+	radixes[S_DECIMAL] = 10;
+	radixes[S_BINARY] = 2;
+	return radixes;
+}
+
+constexpr auto CHAR_CLASSES = makeCharClasses();
+constexpr auto TRANSITIONS = makeTransitions();
+constexpr auto ACCEPTS = makeAccepts();
+constexpr auto RADIXES = makeRadixes();
+
+DfaLexer::DfaLexer(std::string_view _inputString, StringInterner* _symbols) : inputString(_inputString), symbols(_symbols), position(0) {};
+
+CompactToken DfaLexer::getNextToken() {
+	const uint32_t size = uint32_t(inputString.size());
+	const unsigned char* data = reinterpret_cast<const unsigned char*>(inputString.data());
+	const ScanKernels& kernels = scanKernels();
+
+	position = uint32_t(kernels.skipWhitespace(inputString.data() + position, inputString.data() + size) - inputString.data());
+	uint32_t lexemeBegin = position;
+	// Saturates one past INT32_MAX, which marks the literal as out of range
+	const uint64_t limit = uint64_t(INT32_MAX) + 1;
+	uint64_t value = 0;
+	uint8_t state = S_START;
+
+	while (true) {
+		uint8_t charClass = position < size ? CHAR_CLASSES[data[position]] : uint8_t(CC_EOF);
+		uint8_t nextState = TRANSITIONS[state][charClass];
+		if (nextState == S_DONE) { break; }
+
+		if (RADIXES[nextState]) { value = std::min(value * RADIXES[nextState] + (data[position] - '0'), limit); }
+		if (nextState == S_START) { lexemeBegin = position + 1; }
+		if (charClass != CC_EOF) { position++; }
+
+		state = nextState;
+		if (state >= S_FIRST_FINAL) { break; }
+
+		// Identifier runs have no per-character actions, so the rest of the run is skipped at once
+		if (state == S_IDENTIFIER) {
+			position = uint32_t(kernels.skipIdentifier(inputString.data() + position, inputString.data() + size) - inputString.data());
+			break;
+		}
+	}
+
+	const Accept& accept = ACCEPTS[state];
+	position -= accept.backtrack;
+	CompactToken token(accept.type, lexemeBegin, position - lexemeBegin, int32_t(0));
+	if (accept.type == TokenType::IntValue) {
+		// As in Lexer, a literal that doesn't fit is 0 and marked
+		token.outOfRange = value == limit;
+		token.intVal = token.outOfRange ? 0 : int32_t(value);
+	}
+
+	if (accept.type == TokenType::Identifier) {
+		TokenType keyword = classifyKeyword(inputString.substr(token.offset, token.length));
+		if (keyword != TokenType::FAILED) { token.type = keyword; }
+		else if (symbols) { token.symbol = symbols->intern(inputString.substr(token.offset, token.length)); }
+	}
+	else if (accept.type == TokenType::FloatValue) {
+		float floatVal = 0;
+		const char* begin = inputString.data() + token.offset;
+		auto result = std::from_chars(begin, begin + token.length, floatVal);
+		token.outOfRange = result.ec == std::errc::result_out_of_range;
+		token.floatVal = token.outOfRange ? 0 : floatVal;
+	}
+
+	return token;
+}
\ No newline at end of file
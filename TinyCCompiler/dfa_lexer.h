@@ -0,0 +1,25 @@
+#ifndef DFA_LEXER_H
+#define DFA_LEXER_H
+
+#include "token.h"
+#include "string_interner.h"
+
+#include <string_view>
+
+// Single-pass lexer driven by compile-time character class and transition
+// tables. Produces the same token types as Lexer without rescanning input.
+// The source must outlive the lexer. Identifiers are interned into symbols when
+// an interner is given.
+class DfaLexer {
+public:
+	DfaLexer(std::string_view inputString, StringInterner* symbols = nullptr);
+	CompactToken getNextToken();
+	// Continues lexing from the given offset, which must be a token boundary.
+	void setPosition(uint32_t offset) { position = offset; }
+private:
+	std::string_view inputString;
+	StringInterner* symbols;
+	uint32_t position;
+};
+
+#endif
\ No newline at end of file
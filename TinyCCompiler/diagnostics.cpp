@@ -0,0 +1,51 @@
+#include "diagnostics.h"
+
+#include <algorithm>
+
+static const char* const MESSAGES[] = {
+	"Expected 'int'!",
+	"Function definition must have identifier.",
+	"Expected identifier!",
+	"Expected '('!",
+	"Expected ')'!",
+	"Expected '{'!",
+	"Expected '}'!",
+	"Expected ';'!",
+	"Function must return a value!",
+	"Invalid expression!",
+	"Wrong operand!",
+	"Wrong right operand!",
+	"Constant is out of range!",
+	"Undeclared variable!",
+	"Multiple variable declaration is prohibited!",
+	"Function is already defined!",
+};
+
+static_assert(sizeof(MESSAGES) / sizeof(MESSAGES[0]) == size_t(DiagnosticCode::COUNT), "Every diagnostic code needs a message");
+
+void Diagnostics::report(DiagnosticCode code, uint32_t offset) {
+	// Enclosing constructs that fail at the same place would repeat the same complaint
+	if (!records.empty() && records.back().code == code && records.back().offset == offset) { return; }
+	records.push_back({ offset, code });
+}
+
+void Diagnostics::append(const Diagnostics& other) {
+	records.insert(records.end(), other.records.begin(), other.records.end());
+}
+
+const char* Diagnostics::message(DiagnosticCode code) {
+	return MESSAGES[size_t(code)];
+}
+
+std::string Diagnostics::format(const Diagnostic& diagnostic, const TokenSource& source) const {
+	return std::string(message(diagnostic.code)) + " Line " + std::to_string(source.lineAt(diagnostic.offset) + 1)
+		+ " Position " + std::to_string(source.positionAt(diagnostic.offset));
+}
+
+void Diagnostics::print(std::ostream& out, const TokenSource& source) const {
+	std::vector<Diagnostic> sorted(records);
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Diagnostic& a, const Diagnostic& b) { return a.offset < b.offset; });
+	for (const Diagnostic& diagnostic : sorted) {
+		out << format(diagnostic, source) << std::endl;
+	}
+}
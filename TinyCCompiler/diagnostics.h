@@ -0,0 +1,59 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include "token_stream.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class DiagnosticCode : uint8_t {
+	// Syntax
+	EXPECTED_INT,
+	EXPECTED_FUNCTION_NAME,
+	EXPECTED_IDENTIFIER,
+	EXPECTED_OPEN_PARENTHESE,
+	EXPECTED_CLOSE_PARENTHESE,
+	EXPECTED_OPEN_BRACE,
+	EXPECTED_CLOSE_BRACE,
+	EXPECTED_SEMICOLON,
+	MISSING_RETURN_VALUE,
+	INVALID_EXPRESSION,
+	WRONG_OPERAND,
+	WRONG_RIGHT_OPERAND,
+	CONSTANT_OUT_OF_RANGE,
+
+	// Semantics
+	UNDECLARED_VARIABLE,
+	REDECLARED_VARIABLE,
+	REDEFINED_FUNCTION,
+
+	COUNT
+};
+
+// A diagnostic is only a code and a source offset; the message, line and
+// position are worked out when it is printed.
+struct Diagnostic {
+	uint32_t offset;
+	DiagnosticCode code;
+};
+
+class Diagnostics {
+public:
+	void report(DiagnosticCode code, uint32_t offset);
+	void append(const Diagnostics& other);
+
+	bool empty() const { return records.empty(); }
+	size_t size() const { return records.size(); }
+	const Diagnostic& operator[](size_t i) const { return records[i]; }
+
+	static const char* message(DiagnosticCode code);
+	std::string format(const Diagnostic& diagnostic, const TokenSource& source) const;
+	// Prints every diagnostic in source order.
+	void print(std::ostream& out, const TokenSource& source) const;
+private:
+	std::vector<Diagnostic> records;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "flat_ast.h"
+
+NodeIndex FlatAST::add(NodeKind kind, TokenType op, uint32_t first, uint32_t second) {
+	kinds.push_back(kind);
+	ops.push_back(uint8_t(op));
+	firsts.push_back(first);
+	seconds.push_back(second);
+	return NodeIndex(kinds.size() - 1);
+}
+
+uint32_t FlatAST::addName(Symbol name, uint32_t offset) {
+	names.push_back(name);
+	nameOffsets.push_back(offset);
+	return uint32_t(names.size() - 1);
+}
+
+uint32_t FlatAST::addLiteral(int32_t value) {
+	literals.push_back(value);
+	return uint32_t(literals.size() - 1);
+}
+
+uint32_t FlatAST::addChild(NodeIndex child) {
+	childLists.push_back(child);
+	return uint32_t(childLists.size() - 1);
+}
+
+void FlatAST::clear() {
+	kinds.clear();
+	ops.clear();
+	firsts.clear();
+	seconds.clear();
+	names.clear();
+	nameOffsets.clear();
+	literals.clear();
+	childLists.clear();
+}
+
+size_t FlatAST::memoryBytes() const {
+	return kinds.size() * (sizeof(NodeKind) + sizeof(uint8_t) + 2 * sizeof(uint32_t))
+		+ names.size() * (sizeof(Symbol) + sizeof(uint32_t)) + literals.size() * sizeof(int32_t) + childLists.size() * sizeof(NodeIndex);
+}
+
+uint32_t FlatAstBuilder::addChildren(const FlatNode* first, const FlatNode* last) {
+	uint32_t children = uint32_t(first == last ? 0 : ast.addChild(first->index));
+	for (const FlatNode* child = first + 1; child < last; child++) {
+		ast.addChild(child->index);
+	}
+	return children;
+}
+
+FlatNode FlatAstBuilder::condition(FlatNode expr, FlatNode ifClause, FlatNode elseClause) {
+	uint32_t children = ast.addChild(ifClause.index);
+	ast.addChild(elseClause.index);
+	return node(NodeKind::CONDITION, expr.index, children);
+}
+
+FlatNode FlatAstBuilder::statement(StatementType type, FlatNode expr) {
+	NodeKind kind = type == StatementType::RETURN_STATEMENT ? NodeKind::RETURN_STATEMENT : NodeKind::EXPRESSION_STATEMENT;
+	return node(kind, expr.index);
+}
\ No newline at end of file
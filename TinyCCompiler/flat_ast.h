@@ -0,0 +1,118 @@
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "ast.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef uint32_t NodeIndex;
+const NodeIndex NO_NODE = UINT32_MAX;
+
+enum class NodeKind : uint8_t {
+	PROGRAM,              // first: children (functions), second: child count
+	FUNCTION,             // first: name, second: block
+	BLOCK,                // first: children, second: child count
+	DECLARATION,          // first: name, second: initializer or NO_NODE
+	RETURN_STATEMENT,     // first: expression
+	EXPRESSION_STATEMENT, // first: expression
+	CONDITION,            // first: expression, second: children (if block, else block or NO_NODE)
+	INT,                  // first: literal
+	VARIABLE,             // first: name
+	UNARY,                // first: operand
+	BINARY,               // first: left, second: right
+	ASSIGNMENT            // first: name, second: value
+};
+
+// Syntax tree stored as parallel arrays indexed by 32-bit node indices. A node is
+// ten bytes: its kind, operator and two operands, which are child indices or
+// indices into the side tables for names, literals and child lists. Nodes are
+// appended after their children, so the root is the last node.
+class FlatAST {
+public:
+	NodeIndex add(NodeKind kind, TokenType op, uint32_t first, uint32_t second);
+	uint32_t addName(Symbol name, uint32_t offset);
+	uint32_t addLiteral(int32_t value);
+	uint32_t addChild(NodeIndex child);
+	void clear();
+
+	size_t size() const { return kinds.size(); }
+	NodeIndex root() const { return NodeIndex(kinds.size() - 1); }
+	size_t memoryBytes() const;
+
+	NodeKind kind(NodeIndex node) const { return kinds[node]; }
+	TokenType op(NodeIndex node) const { return TokenType(ops[node]); }
+	uint32_t first(NodeIndex node) const { return firsts[node]; }
+	uint32_t second(NodeIndex node) const { return seconds[node]; }
+
+	Symbol name(NodeIndex node) const { return names[firsts[node]]; }
+	uint32_t nameOffset(NodeIndex node) const { return nameOffsets[firsts[node]]; }
+	int32_t literal(NodeIndex node) const { return literals[firsts[node]]; }
+	const NodeIndex* children(NodeIndex node) const { return childLists.data() + firsts[node]; }
+	uint32_t childCount(NodeIndex node) const { return seconds[node]; }
+
+	NodeIndex conditionIf(NodeIndex node) const { return childLists[seconds[node]]; }
+	NodeIndex conditionElse(NodeIndex node) const { return childLists[seconds[node] + 1]; }
+private:
+	std::vector<NodeKind> kinds;
+	std::vector<uint8_t> ops;
+	std::vector<uint32_t> firsts;
+	std::vector<uint32_t> seconds;
+
+	std::vector<Symbol> names;
+	std::vector<uint32_t> nameOffsets; // Where each name occurs in the source, for diagnostics
+	std::vector<int32_t> literals;
+	std::vector<NodeIndex> childLists;
+};
+
+// Handle to a node under construction; converts from nullptr like the pointer
+// handles of the tree AST, so the parser treats both the same way.
+struct FlatNode {
+	NodeIndex index;
+
+	FlatNode(std::nullptr_t = nullptr) : index(NO_NODE) {};
+	explicit FlatNode(NodeIndex _index) : index(_index) {};
+	explicit operator bool() const { return index != NO_NODE; }
+};
+
+// Node factory used by the parser to build a FlatAST.
+class FlatAstBuilder {
+public:
+	typedef FlatNode Program;
+	typedef FlatNode Function;
+	typedef FlatNode Block;
+	typedef FlatNode BlockItem;
+	typedef FlatNode Declaration;
+	typedef FlatNode Condition;
+	typedef FlatNode Statement;
+	typedef FlatNode Expr;
+
+	FlatAstBuilder(FlatAST& _ast) : ast(_ast) {};
+
+	FlatNode program(const FlatNode* first, const FlatNode* last) { return node(NodeKind::PROGRAM, addChildren(first, last), uint32_t(last - first)); }
+	FlatNode function(Symbol name, uint32_t offset, FlatNode block) { return node(NodeKind::FUNCTION, ast.addName(name, offset), block.index); }
+	FlatNode block(const FlatNode* first, const FlatNode* last) { return node(NodeKind::BLOCK, addChildren(first, last), uint32_t(last - first)); }
+	FlatNode declarationItem(FlatNode declaration) { return declaration; }
+	FlatNode statementItem(FlatNode statement) { return statement; }
+	FlatNode declaration(Symbol name, uint32_t offset, FlatNode expr) { return node(NodeKind::DECLARATION, ast.addName(name, offset), expr.index); }
+	FlatNode condition(FlatNode expr, FlatNode ifClause, FlatNode elseClause);
+	FlatNode statement(StatementType type, FlatNode expr);
+	FlatNode blockStatement(FlatNode block) { return block; }
+	FlatNode conditionStatement(FlatNode condition) { return condition; }
+	FlatNode intLiteral(int32_t value) { return node(NodeKind::INT, ast.addLiteral(value)); }
+	FlatNode variable(Symbol name, uint32_t offset) { return node(NodeKind::VARIABLE, ast.addName(name, offset)); }
+	FlatNode unary(TokenType op, FlatNode expr) { return node(NodeKind::UNARY, expr.index, NO_NODE, op); }
+	FlatNode binary(FlatNode left, TokenType op, FlatNode right) { return node(NodeKind::BINARY, left.index, right.index, op); }
+	FlatNode assignment(Symbol name, uint32_t offset, FlatNode expr) { return node(NodeKind::ASSIGNMENT, ast.addName(name, offset), expr.index); }
+private:
+	FlatAST& ast;
+
+	FlatNode node(NodeKind kind, uint32_t first, uint32_t second = NO_NODE, TokenType op = TokenType::FAILED) {
+		return FlatNode(ast.add(kind, op, first, second));
+	}
+
+	uint32_t addChildren(const FlatNode* first, const FlatNode* last);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,238 @@
+#ifndef GRAMMAR_H
+#define GRAMMAR_H
+
+#include "token.h"
+
+#include <cstdint>
+#include <initializer_list>
+
+const size_t TOKEN_TYPE_COUNT = size_t(TokenType::FAILED) + 1;
+
+// Set of token types as a bitmask, usable in constant expressions.
+class TokenSet {
+public:
+	static_assert(TOKEN_TYPE_COUNT <= 64, "TokenSet holds at most 64 token types");
+
+	constexpr TokenSet() : bits(0) {};
+	constexpr TokenSet(std::initializer_list<TokenType> types) : bits(0) {
+		for (TokenType type : types) { bits |= bit(type); }
+	}
+
+	constexpr bool contains(TokenType type) const { return (bits & bit(type)) != 0; }
+	constexpr bool empty() const { return bits == 0; }
+	constexpr TokenSet operator|(TokenSet other) const { return TokenSet(bits | other.bits); }
+	constexpr TokenSet operator&(TokenSet other) const { return TokenSet(bits & other.bits); }
+	constexpr TokenSet without(TokenSet other) const { return TokenSet(bits & ~other.bits); }
+	constexpr bool operator==(TokenSet other) const { return bits == other.bits; }
+	constexpr bool operator!=(TokenSet other) const { return bits != other.bits; }
+private:
+	uint64_t bits;
+
+	constexpr explicit TokenSet(uint64_t _bits) : bits(_bits) {};
+	static constexpr uint64_t bit(TokenType type) { return uint64_t(1) << unsigned(type); }
+};
+
+enum class Nonterminal : uint8_t {
+	PROGRAM,
+	FUNCTION_LIST,
+	FUNCTION,
+	BLOCK,
+	BLOCK_ITEMS,
+	BLOCK_ITEM,
+	DECLARATION,
+	DECLARATION_TAIL,
+	STATEMENT,
+	CONDITION,
+	ELSE_CLAUSE,
+	EXPRESSION,
+	COUNT
+};
+
+// One per production, in the order of GRAMMAR. The parser switches on the rule
+// predicted for the current token.
+enum class Rule : uint8_t {
+	PROGRAM,
+	FUNCTION_LIST_MORE,
+	FUNCTION_LIST_END,
+	FUNCTION,
+	BLOCK,
+	BLOCK_ITEMS_MORE,
+	BLOCK_ITEMS_END,
+	BLOCK_ITEM_DECLARATION,
+	BLOCK_ITEM_STATEMENT,
+	DECLARATION,
+	DECLARATION_EMPTY,
+	DECLARATION_INITIALIZED,
+	STATEMENT_RETURN,
+	STATEMENT_EXPRESSION,
+	STATEMENT_BLOCK,
+	STATEMENT_CONDITION,
+	CONDITION,
+	ELSE_CLAUSE,
+	ELSE_CLAUSE_EMPTY,
+	// Expressions are parsed by operator precedence; the grammar only knows how they begin
+	EXPRESSION_IDENTIFIER,
+	EXPRESSION_INT,
+	EXPRESSION_PARENTHESE,
+	EXPRESSION_NEGATION,
+	EXPRESSION_COMPLEMENT,
+	EXPRESSION_LOGICAL_NEGATION,
+	COUNT,
+	NONE = COUNT
+};
+
+// Grammar symbol: a token type, or a nonterminal numbered after all token types.
+typedef uint8_t GrammarSymbol;
+
+constexpr GrammarSymbol terminal(TokenType type) { return GrammarSymbol(type); }
+constexpr GrammarSymbol nonterminal(Nonterminal symbol) { return GrammarSymbol(TOKEN_TYPE_COUNT + size_t(symbol)); }
+constexpr bool isNonterminal(GrammarSymbol symbol) { return symbol >= TOKEN_TYPE_COUNT; }
+constexpr size_t nonterminalIndex(GrammarSymbol symbol) { return symbol - TOKEN_TYPE_COUNT; }
+
+struct Production {
+	static const size_t MAX_LENGTH = 6;
+
+	Rule rule;
+	Nonterminal lhs;
+	uint8_t length;
+	GrammarSymbol rhs[MAX_LENGTH];
+};
+
+constexpr Production GRAMMAR[] = {
+	{ Rule::PROGRAM, Nonterminal::PROGRAM, 3, { nonterminal(Nonterminal::FUNCTION), nonterminal(Nonterminal::FUNCTION_LIST), terminal(End) } },
+	{ Rule::FUNCTION_LIST_MORE, Nonterminal::FUNCTION_LIST, 2, { nonterminal(Nonterminal::FUNCTION), nonterminal(Nonterminal::FUNCTION_LIST) } },
+	{ Rule::FUNCTION_LIST_END, Nonterminal::FUNCTION_LIST, 0, {} },
+	{ Rule::FUNCTION, Nonterminal::FUNCTION, 5, { terminal(IntType), terminal(Identifier), terminal(OpenParenthese), terminal(CloseParenthese), nonterminal(Nonterminal::BLOCK) } },
+	{ Rule::BLOCK, Nonterminal::BLOCK, 3, { terminal(OpenBrace), nonterminal(Nonterminal::BLOCK_ITEMS), terminal(CloseBrace) } },
+	{ Rule::BLOCK_ITEMS_MORE, Nonterminal::BLOCK_ITEMS, 2, { nonterminal(Nonterminal::BLOCK_ITEM), nonterminal(Nonterminal::BLOCK_ITEMS) } },
+	{ Rule::BLOCK_ITEMS_END, Nonterminal::BLOCK_ITEMS, 0, {} },
+	{ Rule::BLOCK_ITEM_DECLARATION, Nonterminal::BLOCK_ITEM, 1, { nonterminal(Nonterminal::DECLARATION) } },
+	{ Rule::BLOCK_ITEM_STATEMENT, Nonterminal::BLOCK_ITEM, 1, { nonterminal(Nonterminal::STATEMENT) } },
+	{ Rule::DECLARATION, Nonterminal::DECLARATION, 3, { terminal(IntType), terminal(Identifier), nonterminal(Nonterminal::DECLARATION_TAIL) } },
+	{ Rule::DECLARATION_EMPTY, Nonterminal::DECLARATION_TAIL, 1, { terminal(Semicolon) } },
+	{ Rule::DECLARATION_INITIALIZED, Nonterminal::DECLARATION_TAIL, 3, { terminal(Assignment), nonterminal(Nonterminal::EXPRESSION), terminal(Semicolon) } },
+	{ Rule::STATEMENT_RETURN, Nonterminal::STATEMENT, 3, { terminal(ReturnKeyword), nonterminal(Nonterminal::EXPRESSION), terminal(Semicolon) } },
+	{ Rule::STATEMENT_EXPRESSION, Nonterminal::STATEMENT, 2, { nonterminal(Nonterminal::EXPRESSION), terminal(Semicolon) } },
+	{ Rule::STATEMENT_BLOCK, Nonterminal::STATEMENT, 1, { nonterminal(Nonterminal::BLOCK) } },
+	{ Rule::STATEMENT_CONDITION, Nonterminal::STATEMENT, 1, { nonterminal(Nonterminal::CONDITION) } },
+	{ Rule::CONDITION, Nonterminal::CONDITION, 6, { terminal(IfOperator), terminal(OpenParenthese), nonterminal(Nonterminal::EXPRESSION), terminal(CloseParenthese), nonterminal(Nonterminal::BLOCK), nonterminal(Nonterminal::ELSE_CLAUSE) } },
+	{ Rule::ELSE_CLAUSE, Nonterminal::ELSE_CLAUSE, 2, { terminal(ElseOperator), nonterminal(Nonterminal::BLOCK) } },
+	{ Rule::ELSE_CLAUSE_EMPTY, Nonterminal::ELSE_CLAUSE, 0, {} },
+	{ Rule::EXPRESSION_IDENTIFIER, Nonterminal::EXPRESSION, 1, { terminal(Identifier) } },
+	{ Rule::EXPRESSION_INT, Nonterminal::EXPRESSION, 1, { terminal(IntValue) } },
+	{ Rule::EXPRESSION_PARENTHESE, Nonterminal::EXPRESSION, 1, { terminal(OpenParenthese) } },
+	{ Rule::EXPRESSION_NEGATION, Nonterminal::EXPRESSION, 1, { terminal(Negation) } },
+	{ Rule::EXPRESSION_COMPLEMENT, Nonterminal::EXPRESSION, 1, { terminal(BitwiseComplement) } },
+	{ Rule::EXPRESSION_LOGICAL_NEGATION, Nonterminal::EXPRESSION, 1, { terminal(LogicalNegation) } },
+};
+
+const size_t RULE_COUNT = sizeof(GRAMMAR) / sizeof(GRAMMAR[0]);
+const size_t NONTERMINAL_COUNT = size_t(Nonterminal::COUNT);
+
+// FIRST and FOLLOW sets and the LL(1) prediction table of GRAMMAR, computed by
+// fixed-point iteration at compile time.
+class ParseTable {
+public:
+	constexpr ParseTable() : nullable{}, first{}, follow{}, table{}, conflict(false) {
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (const Production& production : GRAMMAR) {
+				size_t lhs = size_t(production.lhs);
+				TokenSet before = first[lhs];
+				first[lhs] = first[lhs] | sequenceFirst(production, 0);
+				bool wasNullable = nullable[lhs];
+				nullable[lhs] = nullable[lhs] || sequenceNullable(production, 0);
+				changed = changed || before != first[lhs] || wasNullable != nullable[lhs];
+			}
+		}
+
+		changed = true;
+		while (changed) {
+			changed = false;
+			for (const Production& production : GRAMMAR) {
+				for (size_t i = 0; i < production.length; i++) {
+					if (!isNonterminal(production.rhs[i])) { continue; }
+
+					size_t target = nonterminalIndex(production.rhs[i]);
+					TokenSet before = follow[target];
+					follow[target] = follow[target] | sequenceFirst(production, i + 1);
+					if (sequenceNullable(production, i + 1)) {
+						follow[target] = follow[target] | follow[size_t(production.lhs)];
+					}
+					changed = changed || before != follow[target];
+				}
+			}
+		}
+
+		for (auto& row : table) {
+			for (auto& rule : row) { rule = Rule::NONE; }
+		}
+		for (const Production& production : GRAMMAR) {
+			TokenSet predicted = sequenceFirst(production, 0);
+			if (sequenceNullable(production, 0)) {
+				predicted = predicted | follow[size_t(production.lhs)];
+			}
+			for (size_t type = 0; type < TOKEN_TYPE_COUNT; type++) {
+				if (!predicted.contains(TokenType(type))) { continue; }
+
+				Rule& rule = table[size_t(production.lhs)][type];
+				conflict = conflict || rule != Rule::NONE;
+				rule = production.rule;
+			}
+		}
+	}
+
+	constexpr Rule predict(Nonterminal nonterminal, TokenType type) const { return table[size_t(nonterminal)][size_t(type)]; }
+	constexpr TokenSet firstSet(Nonterminal nonterminal) const { return first[size_t(nonterminal)]; }
+	constexpr TokenSet followSet(Nonterminal nonterminal) const { return follow[size_t(nonterminal)]; }
+	constexpr bool isLL1() const { return !conflict; }
+private:
+	bool nullable[NONTERMINAL_COUNT];
+	TokenSet first[NONTERMINAL_COUNT];
+	TokenSet follow[NONTERMINAL_COUNT];
+	Rule table[NONTERMINAL_COUNT][TOKEN_TYPE_COUNT];
+	bool conflict;
+
+	constexpr TokenSet sequenceFirst(const Production& production, size_t from) const {
+		TokenSet result;
+		for (size_t i = from; i < production.length; i++) {
+			GrammarSymbol symbol = production.rhs[i];
+			if (!isNonterminal(symbol)) { return result | TokenSet{ TokenType(symbol) }; }
+
+			result = result | first[nonterminalIndex(symbol)];
+			if (!nullable[nonterminalIndex(symbol)]) { break; }
+		}
+		return result;
+	}
+
+	constexpr bool sequenceNullable(const Production& production, size_t from) const {
+		for (size_t i = from; i < production.length; i++) {
+			GrammarSymbol symbol = production.rhs[i];
+			if (!isNonterminal(symbol) || !nullable[nonterminalIndex(symbol)]) { return false; }
+		}
+		return true;
+	}
+};
+
+constexpr bool rulesInOrder() {
+	for (size_t i = 0; i < RULE_COUNT; i++) {
+		if (size_t(GRAMMAR[i].rule) != i) { return false; }
+	}
+	return RULE_COUNT == size_t(Rule::COUNT);
+}
+
+static_assert(rulesInOrder(), "GRAMMAR must list one production per Rule, in order");
+
+constexpr ParseTable PARSE_TABLE;
+static_assert(PARSE_TABLE.isLL1(), "Grammar is not LL(1)");
+
+constexpr TokenSet EXPRESSION_FIRST = PARSE_TABLE.firstSet(Nonterminal::EXPRESSION);
+constexpr TokenSet STATEMENT_FIRST = PARSE_TABLE.firstSet(Nonterminal::STATEMENT);
+constexpr TokenSet BLOCK_ITEM_FIRST = PARSE_TABLE.firstSet(Nonterminal::BLOCK_ITEM);
+
+// Where error recovery resumes: tokens that may follow a block item, except those
+// that may just as well continue a broken expression, and the end of input
+constexpr TokenSet STATEMENT_SYNC = PARSE_TABLE.followSet(Nonterminal::BLOCK_ITEM).without(EXPRESSION_FIRST) | TokenSet{ End };
+
+#endif
\ No newline at end of file
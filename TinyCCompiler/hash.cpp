@@ -0,0 +1,80 @@
+#include "hash.h"
+
+#include <cstring>
+
+static const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t PRIME3 = 0x165667B19E3779F9ull;
+static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+static uint64_t rotateLeft(uint64_t value, int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t read64(const unsigned char* bytes) {
+	uint64_t value;
+	std::memcpy(&value, bytes, 8);
+	return value;
+}
+
+static uint32_t read32(const unsigned char* bytes) {
+	uint32_t value;
+	std::memcpy(&value, bytes, 4);
+	return value;
+}
+
+static uint64_t accumulate(uint64_t accumulator, uint64_t input) {
+	accumulator += input * PRIME2;
+	return rotateLeft(accumulator, 31) * PRIME1;
+}
+
+static uint64_t mergeRound(uint64_t hash, uint64_t accumulator) {
+	hash ^= accumulate(0, accumulator);
+	return hash * PRIME1 + PRIME4;
+}
+
+uint64_t xxHash64(const void* data, size_t size, uint64_t seed) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	const unsigned char* end = bytes + size;
+	uint64_t hash;
+
+	// Four independent lanes over 32-byte stripes
+	if (size >= 32) {
+		uint64_t lanes[4] = { seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1 };
+		for (; end - bytes >= 32; bytes += 32) {
+			for (int i = 0; i < 4; i++) {
+				lanes[i] = accumulate(lanes[i], read64(bytes + 8 * i));
+			}
+		}
+		hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+		for (int i = 0; i < 4; i++) {
+			hash = mergeRound(hash, lanes[i]);
+		}
+	}
+	else {
+		hash = seed + PRIME5;
+	}
+	hash += size;
+
+	for (; end - bytes >= 8; bytes += 8) {
+		hash ^= accumulate(0, read64(bytes));
+		hash = rotateLeft(hash, 27) * PRIME1 + PRIME4;
+	}
+	if (end - bytes >= 4) {
+		hash ^= read32(bytes) * PRIME1;
+		hash = rotateLeft(hash, 23) * PRIME2 + PRIME3;
+		bytes += 4;
+	}
+	for (; bytes < end; bytes++) {
+		hash ^= *bytes * PRIME5;
+		hash = rotateLeft(hash, 11) * PRIME1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+	hash *= PRIME3;
+	hash ^= hash >> 32;
+	return hash;
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// XXH64 of the bytes: fast, well distributed and identical on every little-endian machine,
+// so it can name files shared between processes and build agents.
+uint64_t xxHash64(const void* data, size_t size, uint64_t seed = 0);
+
+inline uint64_t xxHash64(std::string_view bytes, uint64_t seed = 0) {
+	return xxHash64(bytes.data(), bytes.size(), seed);
+}
+
+#endif
\ No newline at end of file
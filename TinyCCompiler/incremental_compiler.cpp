@@ -0,0 +1,266 @@
+#include "incremental_compiler.h"
+#include "lexer.h"
+#include "dfa_lexer.h"
+#include "parser.h"
+#include "code_generator.h"
+#include "hash.h"
+#include "parallel_lexer.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct Fingerprint {
+	uint64_t low;
+	uint64_t high;
+
+	bool operator==(const Fingerprint& other) const { return low == other.low && high == other.high; }
+};
+
+struct FingerprintHash {
+	size_t operator()(const Fingerprint& fingerprint) const { return size_t(fingerprint.low); }
+};
+
+struct FunctionState {
+	std::string name;
+	std::string code;
+};
+
+typedef std::unordered_map<Fingerprint, FunctionState, FingerprintHash> IncrementalState;
+
+// Tokens [first, end) of one top-level function
+struct FunctionRange {
+	int first;
+	int end;
+};
+
+template <class TLexer>
+static void lex(std::string_view source, StringInterner& symbols, TokenStream& tokens) {
+	TLexer lexer(source, &symbols);
+	CompactToken token;
+	do {
+		token = lexer.getNextToken();
+		tokens.push_back(token);
+	} while (token.type != TokenType::End);
+}
+
+// A function ends where its outermost braces close. Ranges of a broken program may not be
+// functions at all, which parsing them then reports.
+static std::vector<FunctionRange> splitFunctions(const TokenStream& tokens) {
+	std::vector<FunctionRange> ranges;
+	int i = 0;
+	while (tokens[i].type != TokenType::End) {
+		FunctionRange range = { i, i };
+		int depth = 0;
+		bool opened = false;
+		while (tokens[i].type != TokenType::End) {
+			TokenType type = tokens[i++].type;
+			if (type == TokenType::OpenBrace) {
+				depth++;
+				opened = true;
+			}
+			else if (type == TokenType::CloseBrace) {
+				depth--;
+			}
+			if (opened && depth <= 0) { break; }
+		}
+		range.end = i;
+		ranges.push_back(range);
+	}
+	return ranges;
+}
+
+// Covers token types and spellings only, so moving a function or reformatting it keeps its code
+static Fingerprint fingerprint(const TokenStream& tokens, FunctionRange range) {
+	std::string spelling;
+	for (int i = range.first; i < range.end; i++) {
+		spelling += char(tokens[i].type);
+		spelling += tokens.lexeme(tokens[i]);
+		spelling += '\0';
+	}
+	return { xxHash64(spelling, 0), xxHash64(spelling, 1) };
+}
+
+static void writeNumber(std::ostream& out, uint64_t value) {
+	out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void writeString(std::ostream& out, const std::string& value) {
+	writeNumber(out, value.size());
+	out.write(value.data(), value.size());
+}
+
+static bool readNumber(std::istream& in, uint64_t& value) {
+	return bool(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+static bool readString(std::istream& in, std::string& value) {
+	uint64_t size;
+	if (!readNumber(in, size) || size > (uint64_t(1) << 32)) { return false; }
+	value.resize(size_t(size));
+	return bool(in.read(&value[0], size));
+}
+
+// The state is only valid for the compiler and options that produced it
+static std::string stateTag(const CompileOptions& options) {
+	return std::string(COMPILER_VERSION) + " incremental " + std::to_string(encodeOptions(options));
+}
+
+static IncrementalState loadState(const std::string& stateFile, const CompileOptions& options) {
+	IncrementalState state;
+	std::ifstream in(stateFile, std::ifstream::binary);
+	std::string tag;
+	uint64_t count;
+	if (!in.is_open() || !readString(in, tag) || tag != stateTag(options) || !readNumber(in, count)) { return state; }
+
+	for (uint64_t i = 0; i < count; i++) {
+		Fingerprint key;
+		FunctionState function;
+		if (!readNumber(in, key.low) || !readNumber(in, key.high) || !readString(in, function.name) || !readString(in, function.code)) {
+			return IncrementalState();
+		}
+		state[key] = std::move(function);
+	}
+	return state;
+}
+
+// Written to a temporary file and renamed, so an interrupted build leaves the old state intact
+static void saveState(const std::string& stateFile, const CompileOptions& options,
+	const std::vector<Fingerprint>& keys, const std::vector<FunctionState>& functions) {
+	std::string temporaryFile = stateFile + "." + std::to_string(std::random_device()()) + ".tmp";
+	{
+		std::ofstream out(temporaryFile, std::ofstream::binary);
+		if (!out.is_open()) { return; }
+		writeString(out, stateTag(options));
+		writeNumber(out, functions.size());
+		for (size_t i = 0; i < functions.size(); i++) {
+			writeNumber(out, keys[i].low);
+			writeNumber(out, keys[i].high);
+			writeString(out, functions[i].name);
+			writeString(out, functions[i].code);
+		}
+		if (!out.flush()) {
+			out.close();
+			std::remove(temporaryFile.c_str());
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryFile, stateFile, error);
+	if (error) { std::filesystem::remove(temporaryFile, error); }
+}
+
+// A function that was edited, and where its code goes
+struct PendingFunction {
+	FunctionAST* function;
+	size_t index;
+};
+
+int compileIncrementally(std::string_view source, const std::string& stateFile, const std::string& outputFile, const CompileOptions& options, ThreadPool* pool, std::ostream& out) {
+	StringInterner symbols;
+	TokenStream tokens(source);
+	if (options.legacyLexer) {
+		lex<Lexer>(source, symbols, tokens);
+	}
+	else if (pool) {
+		lexInParallel(source, &symbols, tokens, *pool);
+	}
+	else {
+		lex<DfaLexer>(source, symbols, tokens);
+	}
+
+	std::vector<FunctionRange> ranges = splitFunctions(tokens);
+	IncrementalState state = loadState(stateFile, options);
+
+	std::vector<Fingerprint> keys;
+	std::vector<FunctionState> functions;
+	std::vector<PendingFunction> pending;
+	std::unordered_set<std::string> names;
+	bool failed = ranges.empty();
+
+	AstArena arena;
+	Parser parser(tokens, arena, options.expressionParsing);
+	for (size_t i = 0; i < ranges.size() && !failed; i++) {
+		keys.push_back(fingerprint(tokens, ranges[i]));
+		auto found = state.find(keys.back());
+		if (found != state.end()) {
+			functions.push_back(found->second);
+		}
+		else {
+			FunctionAST* function = parser.ParseFunction(ranges[i].first);
+			if (!function || parser.NextToken() != ranges[i].end || !parser.GetDiagnostics().empty()) {
+				failed = true;
+				break;
+			}
+			pending.push_back({ function, functions.size() });
+			functions.push_back({ std::string(symbols.name(function->name)), std::string() });
+		}
+		failed = failed || !names.insert(functions.back().name).second;
+	}
+
+	// Each edited function gets a generator of its own, so they can be generated in parallel
+	IrOptions irOptions;
+	irOptions.verify = options.verifyIr;
+	irOptions.dump = options.dumpIr;
+	std::string irDump;
+	IrTimings timings;
+	PeepholeStats peepholeStats;
+	if (!failed) {
+		std::vector<std::unique_ptr<CodeGenerator>> generators(pending.size());
+		std::vector<char> crashed(pending.size(), 0);
+		auto generate = [&](size_t k) {
+			try {
+				generators[k].reset(new CodeGenerator(symbols, nullptr, irOptions));
+				functions[pending[k].index].code = generators[k]->generateCode(*pending[k].function);
+			}
+			catch (const std::exception&) {
+				crashed[k] = 1;
+			}
+		};
+		if (pool) {
+			pool->parallelFor(pending.size(), generate);
+		}
+		else {
+			for (size_t k = 0; k < pending.size(); k++) { generate(k); }
+		}
+
+		for (size_t k = 0; k < pending.size() && !failed; k++) {
+			failed = crashed[k] || !generators[k]->getDiagnostics().empty();
+			irDump += generators[k]->getIrDump();
+			timings.append(generators[k]->getTimings());
+			peepholeStats.append(generators[k]->getPeepholeStats());
+		}
+	}
+
+	if (failed) {
+		return compile(tokens, symbols, pool, outputFile, options, out);
+	}
+
+	std::vector<std::string_view> functionNames;
+	std::vector<std::string> functionCodes;
+	for (FunctionState& function : functions) {
+		functionNames.push_back(function.name);
+		functionCodes.push_back(function.code);
+	}
+	std::string code = CodeGenerator(symbols).programCode(functionNames, functionCodes);
+	if (!writeOutputFile(outputFile, code, out)) { return -1; }
+
+	saveState(stateFile, options, keys, functions);
+	out << irDump;
+	if (options.timePasses) {
+		timings.print(out);
+	}
+	if (options.peepholeStats) {
+		peepholeStats.print(out);
+	}
+	out << "Regenerated " << pending.size() << " of " << functions.size() << " functions" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef INCREMENTAL_COMPILER_H
+#define INCREMENTAL_COMPILER_H
+
+#include "compiler.h"
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Compiles the source, reusing the assembly of every function whose tokens are unchanged
+// since the previous build. stateFile keeps each function's fingerprint, name and code; only
+// new or edited functions are parsed and generated. When anything fails, the whole source is
+// compiled as usual so the diagnostics are the same, and the state is left as it was.
+// With a pool the source is lexed and the edited functions are generated in parallel. The IR
+// dump, timings and peephole statistics cover the functions that were generated.
+// Returns like compile().
+int compileIncrementally(std::string_view source, const std::string& stateFile, const std::string& outputFile, const CompileOptions& options, ThreadPool* pool, std::ostream& out);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "incremental_lexer.h"
+#include "dfa_lexer.h"
+
+#include <algorithm>
+
+// DfaLexer reads at most this many characters past the end of a token before
+// deciding on it ("0b" followed by a non-binary digit)
+static const uint32_t LOOKAHEAD = 2;
+
+size_t relex(TokenStream& tokens, std::string_view newSource, const SourceEdit& edit, StringInterner* symbols) {
+	std::vector<CompactToken>& old = tokens.getTokens();
+	const uint32_t editEnd = edit.offset + edit.removedLength;
+	const int64_t delta = int64_t(edit.insertedText.size()) - int64_t(edit.removedLength);
+
+	// First token whose scan reached into the edit
+	size_t first = std::partition_point(old.begin(), old.end(), [&](const CompactToken& token) {
+		return token.end() + LOOKAHEAD <= edit.offset;
+	}) - old.begin();
+	// First token that starts after the edit; from here old tokens may be reused
+	size_t reusable = std::partition_point(old.begin() + first, old.end(), [&](const CompactToken& token) {
+		return token.offset < editEnd;
+	}) - old.begin();
+
+	DfaLexer lexer(newSource, symbols);
+	uint32_t restart = first < old.size() ? old[first].offset : uint32_t(tokens.getSource().size());
+	lexer.setPosition(std::min(restart, edit.offset));
+
+	std::vector<CompactToken> relexed;
+	size_t resume = old.size();
+	while (true) {
+		CompactToken token = lexer.getNextToken();
+
+		// Skip old tokens that the new token has already passed
+		while (reusable < old.size() && int64_t(old[reusable].offset) + delta < int64_t(token.offset)) { reusable++; }
+		if (reusable < old.size() && int64_t(old[reusable].offset) + delta == int64_t(token.offset)) {
+			resume = reusable;
+			break;
+		}
+
+		relexed.push_back(token);
+		if (token.type == TokenType::End) { break; }
+	}
+
+	for (size_t i = resume; i < old.size(); i++) {
+		old[i].offset = uint32_t(old[i].offset + delta);
+	}
+	old.erase(old.begin() + first, old.begin() + resume);
+	old.insert(old.begin() + first, relexed.begin(), relexed.end());
+
+	tokens.replaceSource(newSource, edit.offset, edit.removedLength, uint32_t(edit.insertedText.size()));
+	return relexed.size();
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef INCREMENTAL_LEXER_H
+#define INCREMENTAL_LEXER_H
+
+#include "token_stream.h"
+#include "string_interner.h"
+
+#include <string_view>
+
+// Replacement of removedLength bytes at offset by insertedText.
+struct SourceEdit {
+	uint32_t offset;
+	uint32_t removedLength;
+	std::string_view insertedText;
+};
+
+// Brings tokens lexed from the old source in line with newSource, the old source
+// with the edit applied. Only the tokens around the edit are lexed again: lexing
+// starts at the first token whose scan could have seen the edited bytes and stops
+// as soon as a new token starts where a shifted old token after the edit starts.
+// Returns the number of tokens that were lexed again.
+size_t relex(TokenStream& tokens, std::string_view newSource, const SourceEdit& edit, StringInterner* symbols);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,537 @@
+#include "ir.h"
+
+#include <algorithm>
+#include <sstream>
+
+static const char* const OP_NAMES[] = {
+	"const", "undef", "phi", "neg", "not", "lnot", "add", "sub", "mul", "div", "and", "or",
+	"eq", "ne", "lt", "gt", "jmp", "br", "ret"
+};
+static_assert(sizeof(OP_NAMES) / sizeof(OP_NAMES[0]) == size_t(IrOp::COUNT), "Every op needs a name");
+
+int operandCount(IrOp op) {
+	switch (op) {
+	case IrOp::CONST:
+	case IrOp::UNDEF:
+	case IrOp::PHI:
+	case IrOp::JUMP:
+		return 0;
+	case IrOp::NEG:
+	case IrOp::NOT:
+	case IrOp::LOGICAL_NOT:
+	case IrOp::BRANCH:
+	case IrOp::RETURN:
+		return 1;
+	default:
+		return 2;
+	}
+}
+
+bool isTerminator(IrOp op) {
+	return op == IrOp::JUMP || op == IrOp::BRANCH || op == IrOp::RETURN;
+}
+
+const char* opName(IrOp op) {
+	return OP_NAMES[size_t(op)];
+}
+
+IrBlock* IrFunction::addBlock() {
+	IrBlock* block = arena.make<IrBlock>();
+	block->id = uint32_t(blocks.size());
+	block->first = nullptr;
+	block->last = nullptr;
+	blocks.push_back(block);
+	return block;
+}
+
+IrInstruction* IrFunction::make(IrOp op, IrType type) {
+	IrInstruction* instruction = arena.make<IrInstruction>();
+	instruction->op = op;
+	instruction->type = type;
+	instruction->id = type == IrType::VOID ? UINT32_MAX : values++;
+	instruction->block = nullptr;
+	instruction->prev = nullptr;
+	instruction->next = nullptr;
+	instruction->operands[0] = nullptr;
+	instruction->operands[1] = nullptr;
+	instruction->targets[0] = nullptr;
+	instruction->targets[1] = nullptr;
+	instruction->constant = 0;
+	return instruction;
+}
+
+IrInstruction* IrFunction::append(IrBlock* block, IrInstruction* instruction) {
+	insert(block, nullptr, instruction);
+	return instruction;
+}
+
+IrInstruction* IrFunction::constant(IrBlock* block, int32_t value) {
+	IrInstruction* instruction = make(IrOp::CONST, IrType::INT32);
+	instruction->constant = value;
+	return append(block, instruction);
+}
+
+IrInstruction* IrFunction::undefined(IrBlock* block) {
+	return append(block, make(IrOp::UNDEF, IrType::INT32));
+}
+
+IrInstruction* IrFunction::unary(IrBlock* block, IrOp op, IrInstruction* operand) {
+	IrInstruction* instruction = make(op, IrType::INT32);
+	instruction->operands[0] = operand;
+	return append(block, instruction);
+}
+
+IrInstruction* IrFunction::binary(IrBlock* block, IrOp op, IrInstruction* left, IrInstruction* right) {
+	IrInstruction* instruction = make(op, IrType::INT32);
+	instruction->operands[0] = left;
+	instruction->operands[1] = right;
+	return append(block, instruction);
+}
+
+IrInstruction* IrFunction::phi(IrBlock* block, const IrPhiInput* first, const IrPhiInput* last) {
+	IrInstruction* instruction = make(IrOp::PHI, IrType::INT32);
+	instruction->incoming = arena.copy(first, last);
+
+	IrInstruction* position = block->first;
+	while (position && position->op == IrOp::PHI) {
+		position = position->next;
+	}
+	insert(block, position, instruction);
+	return instruction;
+}
+
+IrInstruction* IrFunction::jump(IrBlock* block, IrBlock* target) {
+	IrInstruction* instruction = make(IrOp::JUMP, IrType::VOID);
+	instruction->targets[0] = target;
+	return append(block, instruction);
+}
+
+IrInstruction* IrFunction::branch(IrBlock* block, IrInstruction* condition, IrBlock* ifTrue, IrBlock* ifFalse) {
+	IrInstruction* instruction = make(IrOp::BRANCH, IrType::VOID);
+	instruction->operands[0] = condition;
+	instruction->targets[0] = ifTrue;
+	instruction->targets[1] = ifFalse;
+	return append(block, instruction);
+}
+
+IrInstruction* IrFunction::ret(IrBlock* block, IrInstruction* value) {
+	IrInstruction* instruction = make(IrOp::RETURN, IrType::VOID);
+	instruction->operands[0] = value;
+	return append(block, instruction);
+}
+
+void IrFunction::insert(IrBlock* block, IrInstruction* position, IrInstruction* instruction) {
+	instruction->block = block;
+	instruction->next = position;
+	instruction->prev = position ? position->prev : block->last;
+	(instruction->prev ? instruction->prev->next : block->first) = instruction;
+	(position ? position->prev : block->last) = instruction;
+}
+
+void IrFunction::remove(IrInstruction* instruction) {
+	IrBlock* block = instruction->block;
+	(instruction->prev ? instruction->prev->next : block->first) = instruction->next;
+	(instruction->next ? instruction->next->prev : block->last) = instruction->prev;
+	instruction->block = nullptr;
+	instruction->prev = nullptr;
+	instruction->next = nullptr;
+}
+
+static size_t successorCount(const IrBlock* block) {
+	if (!block->last) { return 0; }
+	return block->last->op == IrOp::JUMP ? 1 : block->last->op == IrOp::BRANCH ? 2 : 0;
+}
+
+void IrFunction::computePredecessors() {
+	std::vector<std::vector<IrBlock*>> lists(blocks.size());
+	for (IrBlock* block : blocks) {
+		for (size_t i = 0; i < successorCount(block); i++) {
+			lists[block->last->targets[i]->id].push_back(block);
+		}
+	}
+	for (IrBlock* block : blocks) {
+		std::vector<IrBlock*>& list = lists[block->id];
+		block->predecessors = arena.copy(list.data(), list.data() + list.size());
+	}
+}
+
+void IrFunction::updateControlFlow() {
+	std::vector<IrBlock*> reachable = reversePostorder(*this);
+	std::vector<bool> kept(blocks.size(), false);
+	for (IrBlock* block : reachable) {
+		kept[block->id] = true;
+	}
+
+	size_t count = 0;
+	for (IrBlock* block : blocks) {
+		if (kept[block->id]) {
+			blocks[count++] = block;
+		}
+	}
+	blocks.resize(count);
+	for (size_t i = 0; i < blocks.size(); i++) {
+		blocks[i]->id = uint32_t(i);
+	}
+	computePredecessors();
+
+	for (IrBlock* block : blocks) {
+		for (IrInstruction* phi = block->first; phi && phi->op == IrOp::PHI; phi = phi->next) {
+			uint32_t inputs = 0;
+			for (const IrPhiInput& input : phi->incoming) {
+				if (std::find(block->predecessors.begin(), block->predecessors.end(), input.block) != block->predecessors.end()) {
+					phi->incoming[inputs++] = input;
+				}
+			}
+			phi->incoming.count = inputs;
+		}
+	}
+}
+
+std::vector<IrBlock*> reversePostorder(const IrFunction& function) {
+	std::vector<IrBlock*> order;
+	if (function.blocks.empty()) { return order; }
+
+	// Iterative depth-first search; each entry is a block and its next successor to visit
+	std::vector<bool> visited(function.blocks.size(), false);
+	std::vector<std::pair<IrBlock*, size_t>> stack = { { function.blocks[0], 0 } };
+	visited[0] = true;
+	while (!stack.empty()) {
+		IrBlock* block = stack.back().first;
+		size_t next = stack.back().second++;
+		if (next < successorCount(block)) {
+			IrBlock* successor = block->last->targets[next];
+			if (!visited[successor->id]) {
+				visited[successor->id] = true;
+				stack.push_back({ successor, 0 });
+			}
+		}
+		else {
+			order.push_back(block);
+			stack.pop_back();
+		}
+	}
+	std::reverse(order.begin(), order.end());
+	return order;
+}
+
+static void printValue(const IrInstruction* value, std::ostream& out) {
+	if (value) {
+		out << '%' << value->id;
+	}
+	else {
+		out << "<null>";
+	}
+}
+
+static void printBlockName(const IrBlock* block, std::ostream& out) {
+	if (block) {
+		out << "block" << block->id;
+	}
+	else {
+		out << "<null>";
+	}
+}
+
+void printIr(const IrFunction& function, std::ostream& out) {
+	out << "function " << function.name << '\n';
+	for (const IrBlock* block : function.blocks) {
+		printBlockName(block, out);
+		out << ':';
+		for (size_t i = 0; i < block->predecessors.size(); i++) {
+			out << (i == 0 ? " ; preds " : ", ");
+			printBlockName(block->predecessors[i], out);
+		}
+		out << '\n';
+
+		for (const IrInstruction* instruction = block->first; instruction; instruction = instruction->next) {
+			out << '\t';
+			if (instruction->type != IrType::VOID) {
+				out << '%' << instruction->id << " = ";
+			}
+			out << opName(instruction->op);
+			if (instruction->type == IrType::INT32) {
+				out << " i32";
+			}
+
+			const char* separator = " ";
+			for (int i = 0; i < operandCount(instruction->op); i++) {
+				out << separator;
+				printValue(instruction->operands[i], out);
+				separator = ", ";
+			}
+			switch (instruction->op) {
+			case IrOp::CONST:
+				out << ' ' << instruction->constant;
+				break;
+			case IrOp::PHI:
+				for (const IrPhiInput& input : instruction->incoming) {
+					out << separator << '[';
+					printValue(input.value, out);
+					out << ", ";
+					printBlockName(input.block, out);
+					out << ']';
+					separator = ", ";
+				}
+				break;
+			case IrOp::JUMP:
+				out << ' ';
+				printBlockName(instruction->targets[0], out);
+				break;
+			case IrOp::BRANCH:
+				out << ", ";
+				printBlockName(instruction->targets[0], out);
+				out << ", ";
+				printBlockName(instruction->targets[1], out);
+				break;
+			default:
+				break;
+			}
+			out << '\n';
+		}
+	}
+}
+
+// Where each value is defined, for the dominance checks
+struct Definition {
+	const IrBlock* block;
+	uint32_t position;
+};
+
+class IrVerifier {
+public:
+	IrVerifier(const IrFunction& _function) : function(_function) {};
+
+	bool run(std::string& error);
+private:
+	const IrFunction& function;
+	std::ostringstream message;
+
+	std::vector<Definition> definitions;
+	std::vector<const IrBlock*> dominators; // Immediate dominator of each reachable block, by block id
+	std::vector<uint32_t> order;           // Reverse postorder number of each reachable block
+
+	bool fail(const IrBlock* block, const IrInstruction* instruction);
+	bool checkBlocks();
+	bool checkControlFlow();
+	bool checkUses();
+	bool dominates(const IrBlock* dominator, const IrBlock* block) const;
+	bool available(const IrInstruction* value, const IrBlock* block, uint32_t position) const;
+};
+
+bool IrVerifier::fail(const IrBlock* block, const IrInstruction* instruction) {
+	std::ostringstream prefix;
+	prefix << function.name << ", ";
+	printBlockName(block, prefix);
+	if (instruction) {
+		prefix << ", " << opName(instruction->op);
+		if (instruction->type != IrType::VOID) {
+			prefix << ' ';
+			printValue(instruction, prefix);
+		}
+	}
+	message.str(prefix.str() + ": " + message.str());
+	return false;
+}
+
+bool IrVerifier::run(std::string& error) {
+	bool valid = checkBlocks() && checkControlFlow() && checkUses();
+	if (!valid) { error = message.str(); }
+	return valid;
+}
+
+bool IrVerifier::checkBlocks() {
+	if (function.blocks.empty()) {
+		message << "no entry block";
+		return fail(nullptr, nullptr);
+	}
+
+	definitions.assign(function.valueCount(), { nullptr, 0 });
+	for (size_t i = 0; i < function.blocks.size(); i++) {
+		const IrBlock* block = function.blocks[i];
+		if (block->id != i) {
+			message << "listed at index " << i;
+			return fail(block, nullptr);
+		}
+		if (!block->last || !isTerminator(block->last->op)) {
+			message << "doesn't end in a terminator";
+			return fail(block, nullptr);
+		}
+
+		uint32_t position = 0;
+		bool phis = true;
+		for (const IrInstruction* instruction = block->first; instruction; instruction = instruction->next, position++) {
+			if (instruction->block != block || (instruction->next ? instruction->next->prev : block->last) != instruction) {
+				message << "badly linked";
+				return fail(block, instruction);
+			}
+			if (isTerminator(instruction->op) && instruction != block->last) {
+				message << "terminator in the middle of the block";
+				return fail(block, instruction);
+			}
+			if (instruction->op == IrOp::PHI && !phis) {
+				message << "phi after other instructions";
+				return fail(block, instruction);
+			}
+			phis = instruction->op == IrOp::PHI;
+
+			IrType type = isTerminator(instruction->op) ? IrType::VOID : IrType::INT32;
+			if (instruction->type != type) {
+				message << "wrong result type";
+				return fail(block, instruction);
+			}
+			for (int j = 0; j < operandCount(instruction->op); j++) {
+				if (!instruction->operands[j] || instruction->operands[j]->type != IrType::INT32) {
+					message << "operand " << j << " is not an i32 value";
+					return fail(block, instruction);
+				}
+			}
+			int targets = instruction->op == IrOp::BRANCH ? 2 : instruction->op == IrOp::JUMP ? 1 : 0;
+			for (int j = 0; j < targets; j++) {
+				const IrBlock* target = instruction->targets[j];
+				if (!target || target->id >= function.blocks.size() || function.blocks[target->id] != target) {
+					message << "target " << j << " is not a block of the function";
+					return fail(block, instruction);
+				}
+			}
+
+			if (type == IrType::INT32) {
+				if (instruction->id >= definitions.size() || definitions[instruction->id].block) {
+					message << "value number is out of range or defined twice";
+					return fail(block, instruction);
+				}
+				definitions[instruction->id] = { block, position };
+			}
+		}
+	}
+	return true;
+}
+
+bool IrVerifier::checkControlFlow() {
+	std::vector<std::vector<const IrBlock*>> predecessors(function.blocks.size());
+	for (const IrBlock* block : function.blocks) {
+		for (size_t i = 0; i < successorCount(block); i++) {
+			predecessors[block->last->targets[i]->id].push_back(block);
+		}
+	}
+
+	for (const IrBlock* block : function.blocks) {
+		std::vector<const IrBlock*> expected = predecessors[block->id];
+		std::vector<const IrBlock*> listed(block->predecessors.begin(), block->predecessors.end());
+		std::sort(expected.begin(), expected.end());
+		std::sort(listed.begin(), listed.end());
+		if (expected != listed) {
+			message << "predecessor list is out of date";
+			return fail(block, nullptr);
+		}
+		if (block->id == 0 && !listed.empty()) {
+			message << "entry block has predecessors";
+			return fail(block, nullptr);
+		}
+
+		for (const IrInstruction* phi = block->first; phi && phi->op == IrOp::PHI; phi = phi->next) {
+			std::vector<const IrBlock*> sources;
+			for (const IrPhiInput& input : phi->incoming) {
+				if (!input.value || input.value->type != IrType::INT32) {
+					message << "incoming value is not an i32 value";
+					return fail(block, phi);
+				}
+				sources.push_back(input.block);
+			}
+			std::sort(sources.begin(), sources.end());
+			if (sources != expected) {
+				message << "incoming blocks don't match the predecessors";
+				return fail(block, phi);
+			}
+		}
+	}
+
+	// The language has no loops and the code generator relies on it: phis of a block never
+	// feed each other, so their copies can be made one by one
+	std::vector<IrBlock*> reverse = reversePostorder(function);
+	order.assign(function.blocks.size(), UINT32_MAX);
+	for (size_t i = 0; i < reverse.size(); i++) {
+		order[reverse[i]->id] = uint32_t(i);
+	}
+	for (const IrBlock* block : reverse) {
+		for (const IrBlock* predecessor : block->predecessors) {
+			if (order[predecessor->id] != UINT32_MAX && order[predecessor->id] >= order[block->id]) {
+				message << "loop back from ";
+				printBlockName(predecessor, message);
+				return fail(block, nullptr);
+			}
+		}
+	}
+
+	// Without back edges one pass in reverse postorder settles the immediate dominators
+	// (Cooper, Harvey and Kennedy's algorithm)
+	dominators.assign(function.blocks.size(), nullptr);
+	dominators[0] = function.blocks[0];
+	for (size_t i = 1; i < reverse.size(); i++) {
+		const IrBlock* dominator = nullptr;
+		for (const IrBlock* predecessor : reverse[i]->predecessors) {
+			if (order[predecessor->id] == UINT32_MAX) { continue; }
+			if (!dominator) {
+				dominator = predecessor;
+				continue;
+			}
+			const IrBlock* other = predecessor;
+			while (dominator != other) {
+				while (order[dominator->id] > order[other->id]) { dominator = dominators[dominator->id]; }
+				while (order[other->id] > order[dominator->id]) { other = dominators[other->id]; }
+			}
+		}
+		dominators[reverse[i]->id] = dominator;
+	}
+	return true;
+}
+
+bool IrVerifier::dominates(const IrBlock* dominator, const IrBlock* block) const {
+	while (block != dominator && block->id != 0) {
+		block = dominators[block->id];
+	}
+	return block == dominator;
+}
+
+// Whether value is defined before the given position of a reachable block on every path
+bool IrVerifier::available(const IrInstruction* value, const IrBlock* block, uint32_t position) const {
+	if (value->id >= definitions.size()) { return false; }
+	Definition definition = definitions[value->id];
+	if (!definition.block || order[definition.block->id] == UINT32_MAX) { return false; }
+	if (definition.block == block) { return definition.position < position; }
+	return dominates(definition.block, block);
+}
+
+bool IrVerifier::checkUses() {
+	for (const IrBlock* block : function.blocks) {
+		// Code that can't run is not checked
+		if (order[block->id] == UINT32_MAX) { continue; }
+
+		uint32_t position = 0;
+		for (const IrInstruction* instruction = block->first; instruction; instruction = instruction->next, position++) {
+			for (int i = 0; i < operandCount(instruction->op); i++) {
+				if (!available(instruction->operands[i], block, position)) {
+					message << "operand ";
+					printValue(instruction->operands[i], message);
+					message << " is not defined on every path";
+					return fail(block, instruction);
+				}
+			}
+			if (instruction->op != IrOp::PHI) { continue; }
+
+			for (const IrPhiInput& input : instruction->incoming) {
+				if (order[input.block->id] != UINT32_MAX && !available(input.value, input.block, UINT32_MAX)) {
+					message << "incoming ";
+					printValue(input.value, message);
+					message << " is not defined at the end of ";
+					printBlockName(input.block, message);
+					return fail(block, instruction);
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool verifyIr(const IrFunction& function, std::string& error) {
+	return IrVerifier(function).run(error);
+}
\ No newline at end of file
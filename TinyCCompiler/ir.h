@@ -0,0 +1,129 @@
+#ifndef IR_H
+#define IR_H
+
+#include "ast_arena.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class IrType : uint8_t {
+	VOID,   // Terminators, which define no value
+	INT32
+};
+
+enum class IrOp : uint8_t {
+	CONST,        // constant
+	UNDEF,        // Any value; what ebx holds before a function has computed anything
+	PHI,          // The incoming value of the predecessor control came from
+	NEG,          // -operands[0]
+	NOT,          // ~operands[0]
+	LOGICAL_NOT,  // operands[0] == 0
+	ADD,          // operands[0] + operands[1], and so on for the operators up to GT
+	SUB,
+	MUL,
+	DIV,          // Divides the low 16 bits unsigned and keeps the high half of the dividend, like div bx
+	AND,          // Bitwise; the language's && and || don't short-circuit
+	OR,
+	EQ,
+	NE,
+	LT,
+	GT,
+	JUMP,         // To targets[0]
+	BRANCH,       // To targets[0] when operands[0] != 0 and to targets[1] otherwise
+	RETURN,       // Returns operands[0]
+
+	COUNT
+};
+
+struct IrBlock;
+struct IrInstruction;
+
+struct IrPhiInput {
+	IrBlock* block;
+	IrInstruction* value;
+};
+
+// An instruction is also the virtual register it defines. Instructions are arena nodes linked
+// into their block, so passes can unlink and insert them in place; operands point straight at
+// the instructions that define them.
+struct IrInstruction {
+	IrOp op;
+	IrType type;
+	uint32_t id;                    // Virtual register number, %id in dumps
+	IrBlock* block;
+	IrInstruction* prev;
+	IrInstruction* next;
+	IrInstruction* operands[2];
+	IrBlock* targets[2];            // JUMP and BRANCH
+	int32_t constant;               // CONST
+	ArenaSpan<IrPhiInput> incoming; // PHI, one input per predecessor
+};
+
+// Straight-line instructions ending in exactly one terminator. Phis come first.
+struct IrBlock {
+	uint32_t id;
+	IrInstruction* first;
+	IrInstruction* last;
+	ArenaSpan<IrBlock*> predecessors; // As of the last computePredecessors()
+};
+
+int operandCount(IrOp op);
+bool isTerminator(IrOp op);
+const char* opName(IrOp op);
+
+// A function in SSA form: every virtual register is assigned once, and values meeting where
+// control flow joins are merged by phis. The blocks are listed in layout order, the entry first.
+class IrFunction {
+public:
+	explicit IrFunction(std::string_view _name) : name(_name), values(0) {};
+	IrFunction(const IrFunction&) = delete;
+	IrFunction& operator=(const IrFunction&) = delete;
+
+	std::string_view name;
+	std::vector<IrBlock*> blocks;
+
+	IrBlock* addBlock();
+	uint32_t valueCount() const { return values; }
+
+	// Instructions are appended to the block; phis go after the phis already there
+	IrInstruction* constant(IrBlock* block, int32_t value);
+	IrInstruction* undefined(IrBlock* block);
+	IrInstruction* unary(IrBlock* block, IrOp op, IrInstruction* operand);
+	IrInstruction* binary(IrBlock* block, IrOp op, IrInstruction* left, IrInstruction* right);
+	IrInstruction* phi(IrBlock* block, const IrPhiInput* first, const IrPhiInput* last);
+	IrInstruction* jump(IrBlock* block, IrBlock* target);
+	IrInstruction* branch(IrBlock* block, IrInstruction* condition, IrBlock* ifTrue, IrBlock* ifFalse);
+	IrInstruction* ret(IrBlock* block, IrInstruction* value);
+
+	// Links a detached or unlinked instruction in before position, or at the end for nullptr
+	void insert(IrBlock* block, IrInstruction* position, IrInstruction* instruction);
+	// Unlinks the instruction; uses of it have to be gone or replaced already
+	void remove(IrInstruction* instruction);
+
+	// Derives the predecessor lists from the terminators, after the control flow changed
+	void computePredecessors();
+	// As computePredecessors(), but first drops the blocks control no longer reaches and
+	// renumbers the rest; phis lose the inputs of edges that are gone
+	void updateControlFlow();
+private:
+	AstArena arena;
+	uint32_t values;
+
+	IrInstruction* make(IrOp op, IrType type);
+	IrInstruction* append(IrBlock* block, IrInstruction* instruction);
+};
+
+// Reachable blocks in reverse postorder, so every block comes after its dominators
+std::vector<IrBlock*> reversePostorder(const IrFunction& function);
+
+// Prints the function as text, one instruction per line
+void printIr(const IrFunction& function, std::ostream& out);
+
+// Checks the structure, types, control flow and SSA properties of the function. On failure
+// error describes the first problem found.
+bool verifyIr(const IrFunction& function, std::string& error);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "ir_passes.h"
+
+#include <vector>
+
+// Computes op the way the generated code does: in 32 bits with wrap-around, with && and || as
+// bitwise operators and division as div bx. Division by zero is left to trap at run time.
+static bool evaluate(IrOp op, uint32_t left, uint32_t right, int32_t& result) {
+	uint32_t value;
+	switch (op) {
+	case IrOp::NEG: value = 0u - left; break;
+	case IrOp::NOT: value = ~left; break;
+	case IrOp::LOGICAL_NOT: value = left == 0; break;
+	case IrOp::ADD: value = left + right; break;
+	case IrOp::SUB: value = left - right; break;
+	case IrOp::MUL: value = left * right; break;
+	case IrOp::DIV:
+		if ((right & 0xFFFF) == 0) { return false; }
+		value = (left & 0xFFFF0000) | ((left & 0xFFFF) / (right & 0xFFFF));
+		break;
+	case IrOp::AND: value = left & right; break;
+	case IrOp::OR: value = left | right; break;
+	case IrOp::EQ: value = left == right; break;
+	case IrOp::NE: value = left != right; break;
+	case IrOp::LT: value = int32_t(left) < int32_t(right); break;
+	case IrOp::GT: value = int32_t(left) > int32_t(right); break;
+	default: return false;
+	}
+	result = int32_t(value);
+	return true;
+}
+
+static void makeConstant(IrInstruction* instruction, int32_t value) {
+	instruction->op = IrOp::CONST;
+	instruction->constant = value;
+	instruction->operands[0] = nullptr;
+	instruction->operands[1] = nullptr;
+	instruction->incoming = ArenaSpan<IrPhiInput>();
+}
+
+// Whether control can go from one block to the other, given the branches folded so far
+static bool liveEdge(const IrBlock* from, const IrBlock* to, const std::vector<bool>& reachable) {
+	const IrInstruction* terminator = from->last;
+	return reachable[from->id]
+		&& (terminator->targets[0] == to || (terminator->op == IrOp::BRANCH && terminator->targets[1] == to));
+}
+
+// Without loops every block comes after all its predecessors in reverse postorder, so a
+// single pass sees each value's final state before its uses, and the edges that can run
+// before the phis merging them.
+bool foldConstants(IrFunction& function) {
+	std::vector<IrInstruction*> replacements(function.valueCount(), nullptr);
+	std::vector<bool> reachable(function.blocks.size(), false);
+	reachable[0] = true;
+	bool changed = false;
+	bool branchFolded = false;
+
+	auto resolve = [&](IrInstruction* value) {
+		return replacements[value->id] ? replacements[value->id] : value;
+	};
+
+	for (IrBlock* block : reversePostorder(function)) {
+		if (!reachable[block->id]) { continue; }
+
+		IrInstruction* next;
+		for (IrInstruction* instruction = block->first; instruction; instruction = next) {
+			next = instruction->next;
+			for (int i = 0; i < operandCount(instruction->op); i++) {
+				instruction->operands[i] = resolve(instruction->operands[i]);
+			}
+
+			if (instruction->op == IrOp::PHI) {
+				// Only the inputs of edges that can run count; a phi with one distinct value
+				// is that value
+				IrInstruction* same = nullptr;
+				bool distinct = false;
+				bool constant = true;
+				for (IrPhiInput& input : instruction->incoming) {
+					if (!liveEdge(input.block, block, reachable)) { continue; }
+					input.value = resolve(input.value);
+					distinct = distinct || (same && same != input.value);
+					constant = constant && input.value->op == IrOp::CONST && (!same || same->op != IrOp::CONST || same->constant == input.value->constant);
+					if (!same) { same = input.value; }
+				}
+				if (same && !distinct) {
+					replacements[instruction->id] = same;
+					function.remove(instruction);
+					changed = true;
+				}
+				else if (same && constant) {
+					// Phis come first, so the constant moves after them
+					IrInstruction* position = instruction->next;
+					while (position->op == IrOp::PHI) {
+						position = position->next;
+					}
+					function.remove(instruction);
+					function.insert(block, position, instruction);
+					makeConstant(instruction, same->constant);
+					changed = true;
+				}
+			}
+			else if (instruction->op == IrOp::BRANCH) {
+				if (instruction->operands[0]->op == IrOp::CONST) {
+					instruction->op = IrOp::JUMP;
+					instruction->targets[0] = instruction->targets[instruction->operands[0]->constant != 0 ? 0 : 1];
+					instruction->targets[1] = nullptr;
+					instruction->operands[0] = nullptr;
+					changed = true;
+					branchFolded = true;
+				}
+			}
+			else if (!isTerminator(instruction->op) && operandCount(instruction->op) > 0) {
+				const IrInstruction* left = instruction->operands[0];
+				const IrInstruction* right = instruction->operands[1];
+				int32_t value;
+				if (left->op == IrOp::CONST && (!right || right->op == IrOp::CONST)
+					&& evaluate(instruction->op, uint32_t(left->constant), right ? uint32_t(right->constant) : 0, value)) {
+					makeConstant(instruction, value);
+					changed = true;
+				}
+			}
+		}
+
+		IrInstruction* terminator = block->last;
+		if (terminator->op != IrOp::RETURN) {
+			reachable[terminator->targets[0]->id] = true;
+		}
+		if (terminator->op == IrOp::BRANCH) {
+			reachable[terminator->targets[1]->id] = true;
+		}
+	}
+
+	if (branchFolded) {
+		function.updateControlFlow();
+	}
+	return changed;
+}
\ No newline at end of file
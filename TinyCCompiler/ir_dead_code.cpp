@@ -0,0 +1,139 @@
+#include "ir_passes.h"
+
+#include <vector>
+
+// Phis whose inputs are all the same value, typically because the other edges were removed
+static bool replaceTrivialPhis(IrFunction& function) {
+	std::vector<IrInstruction*> replacements(function.valueCount(), nullptr);
+	auto resolve = [&](IrInstruction* value) {
+		return replacements[value->id] ? replacements[value->id] : value;
+	};
+
+	// Inputs are defined in dominators of the phi's block, which reverse postorder visits
+	// first, so a replacement is final when it is made
+	bool changed = false;
+	for (IrBlock* block : reversePostorder(function)) {
+		IrInstruction* next;
+		for (IrInstruction* phi = block->first; phi && phi->op == IrOp::PHI; phi = next) {
+			next = phi->next;
+			IrInstruction* same = nullptr;
+			bool distinct = false;
+			for (IrPhiInput& input : phi->incoming) {
+				input.value = resolve(input.value);
+				distinct = distinct || (same && same != input.value);
+				if (!same) { same = input.value; }
+			}
+			if (same && !distinct) {
+				replacements[phi->id] = same;
+				function.remove(phi);
+				changed = true;
+			}
+		}
+	}
+	if (!changed) { return false; }
+
+	for (IrBlock* block : function.blocks) {
+		for (IrInstruction* instruction = block->first; instruction; instruction = instruction->next) {
+			for (int i = 0; i < operandCount(instruction->op); i++) {
+				instruction->operands[i] = resolve(instruction->operands[i]);
+			}
+			for (IrPhiInput& input : instruction->incoming) {
+				input.value = resolve(input.value);
+			}
+		}
+	}
+	return true;
+}
+
+// Values nothing uses, then the values only those used. Unused divisions go as well, so a
+// division by zero whose result is never used no longer traps.
+static bool removeUnusedValues(IrFunction& function) {
+	std::vector<uint32_t> uses(function.valueCount(), 0);
+	for (IrBlock* block : function.blocks) {
+		for (IrInstruction* instruction = block->first; instruction; instruction = instruction->next) {
+			for (int i = 0; i < operandCount(instruction->op); i++) {
+				uses[instruction->operands[i]->id]++;
+			}
+			for (const IrPhiInput& input : instruction->incoming) {
+				uses[input.value->id]++;
+			}
+		}
+	}
+
+	std::vector<IrInstruction*> unused;
+	for (IrBlock* block : function.blocks) {
+		for (IrInstruction* instruction = block->first; instruction; instruction = instruction->next) {
+			if (!isTerminator(instruction->op) && uses[instruction->id] == 0) {
+				unused.push_back(instruction);
+			}
+		}
+	}
+
+	bool changed = !unused.empty();
+	while (!unused.empty()) {
+		IrInstruction* instruction = unused.back();
+		unused.pop_back();
+		for (int i = 0; i < operandCount(instruction->op); i++) {
+			if (--uses[instruction->operands[i]->id] == 0) {
+				unused.push_back(instruction->operands[i]);
+			}
+		}
+		for (const IrPhiInput& input : instruction->incoming) {
+			if (--uses[input.value->id] == 0) {
+				unused.push_back(input.value);
+			}
+		}
+		function.remove(instruction);
+	}
+	return changed;
+}
+
+// A block whose only predecessor jumps to it is appended to that predecessor
+static bool mergeBlocks(IrFunction& function) {
+	bool changed = false;
+	for (IrBlock* block : function.blocks) {
+		IrInstruction* jump = block->last;
+		while (jump && jump->op == IrOp::JUMP && jump->targets[0] != block && jump->targets[0]->predecessors.size() == 1) {
+			// A single predecessor leaves no phis, as replaceTrivialPhis ran first
+			IrBlock* successor = jump->targets[0];
+			function.remove(jump);
+			IrInstruction* next;
+			for (IrInstruction* instruction = successor->first; instruction; instruction = next) {
+				next = instruction->next;
+				function.remove(instruction);
+				function.insert(block, nullptr, instruction);
+			}
+
+			// Edges out of the successor now leave from the block
+			IrInstruction* terminator = block->last;
+			for (int i = 0; i < (terminator->op == IrOp::BRANCH ? 2 : terminator->op == IrOp::JUMP ? 1 : 0); i++) {
+				for (IrInstruction* phi = terminator->targets[i]->first; phi && phi->op == IrOp::PHI; phi = phi->next) {
+					for (IrPhiInput& input : phi->incoming) {
+						if (input.block == successor) {
+							input.block = block;
+						}
+					}
+				}
+			}
+			jump = terminator;
+			changed = true;
+		}
+	}
+
+	// The emptied blocks have no predecessors left
+	if (changed) {
+		function.updateControlFlow();
+	}
+	return changed;
+}
+
+bool eliminateDeadCode(IrFunction& function) {
+	size_t blocks = function.blocks.size();
+	function.updateControlFlow();
+	bool changed = function.blocks.size() != blocks;
+
+	changed = replaceTrivialPhis(function) || changed;
+	changed = removeUnusedValues(function) || changed;
+	changed = mergeBlocks(function) || changed;
+	return changed;
+}
\ No newline at end of file
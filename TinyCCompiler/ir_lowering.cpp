@@ -0,0 +1,470 @@
+#include "ir_lowering.h"
+
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+enum class ItemKind { DECLARATION, RETURN_STATEMENT, EXPRESSION_STATEMENT, BLOCK, CONDITION };
+enum class ExpressionKind { INT, VARIABLE, UNARY, BINARY, ASSIGNMENT };
+
+// Functions of either tree layout, as the lowering walks them. Items are declarations and
+// statements; first() is the operand of a unary operator, the left operand of a binary one
+// and the assigned value.
+struct ArenaTree {
+	typedef const BlockAST* Block;
+	typedef const BlockItemAST* Item;
+	typedef const ExprAST* Expr;
+
+	size_t itemCount(Block block) const { return block->items.size(); }
+	Item item(Block block, size_t i) const { return block->items[i]; }
+	ItemKind itemKind(Item item) const {
+		if (item->type == BlockItemType::DECLARATION) { return ItemKind::DECLARATION; }
+		switch (item->statement->type) {
+		case StatementType::RETURN_STATEMENT: return ItemKind::RETURN_STATEMENT;
+		case StatementType::EXPRESSION_STATEMENT: return ItemKind::EXPRESSION_STATEMENT;
+		case StatementType::BLOCK: return ItemKind::BLOCK;
+		case StatementType::CONDITION: return ItemKind::CONDITION;
+		}
+		throw std::runtime_error("Unsupported statement!");
+	}
+
+	Symbol declaredName(Item item) const { return item->declaration->varName; }
+	uint32_t declaredOffset(Item item) const { return item->declaration->offset; }
+	bool initialized(Item item) const { return item->declaration->expr != nullptr; }
+	Expr initializer(Item item) const { return item->declaration->expr; }
+	Expr statementExpr(Item item) const { return item->statement->expr; }
+	Block statementBlock(Item item) const { return item->statement->block; }
+	Expr conditionExpr(Item item) const { return item->statement->condition->expr; }
+	Block ifClause(Item item) const { return item->statement->condition->ifClause; }
+	bool hasElse(Item item) const { return item->statement->condition->elseClause != nullptr; }
+	Block elseClause(Item item) const { return item->statement->condition->elseClause; }
+
+	ExpressionKind kind(Expr node) const {
+		switch (node->type) {
+		case ExpressionType::EXPR_INT: return ExpressionKind::INT;
+		case ExpressionType::EXPR_VARIABLE: return ExpressionKind::VARIABLE;
+		case ExpressionType::EXPR_UNARY: return ExpressionKind::UNARY;
+		case ExpressionType::EXPR_BINARY: return ExpressionKind::BINARY;
+		case ExpressionType::EXPR_ASSIGNMENT: return ExpressionKind::ASSIGNMENT;
+		}
+		throw std::runtime_error("Unsupported expression!");
+	}
+	Expr first(Expr node) const {
+		return node->type == ExpressionType::EXPR_UNARY ? node->unary.expr
+			: node->type == ExpressionType::EXPR_BINARY ? node->binary.left : node->varAssignment.expr;
+	}
+	Expr second(Expr node) const { return node->binary.right; }
+	TokenType op(Expr node) const { return node->type == ExpressionType::EXPR_UNARY ? node->unary.unOp : node->binary.binOp; }
+	int32_t literal(Expr node) const { return node->intVal; }
+	Symbol name(Expr node) const { return node->type == ExpressionType::EXPR_VARIABLE ? node->varName : node->varAssignment.varName; }
+	uint32_t offset(Expr node) const { return node->offset; }
+};
+
+struct FlatTree {
+	typedef NodeIndex Block;
+	typedef NodeIndex Item;
+	typedef NodeIndex Expr;
+	const FlatAST& ast;
+
+	size_t itemCount(Block block) const { return ast.childCount(block); }
+	Item item(Block block, size_t i) const { return ast.children(block)[i]; }
+	ItemKind itemKind(Item item) const {
+		switch (ast.kind(item)) {
+		case NodeKind::DECLARATION: return ItemKind::DECLARATION;
+		case NodeKind::RETURN_STATEMENT: return ItemKind::RETURN_STATEMENT;
+		case NodeKind::EXPRESSION_STATEMENT: return ItemKind::EXPRESSION_STATEMENT;
+		case NodeKind::BLOCK: return ItemKind::BLOCK;
+		case NodeKind::CONDITION: return ItemKind::CONDITION;
+		default: throw std::runtime_error("Unsupported node!");
+		}
+	}
+
+	Symbol declaredName(Item item) const { return ast.name(item); }
+	uint32_t declaredOffset(Item item) const { return ast.nameOffset(item); }
+	bool initialized(Item item) const { return ast.second(item) != NO_NODE; }
+	Expr initializer(Item item) const { return ast.second(item); }
+	Expr statementExpr(Item item) const { return ast.first(item); }
+	Block statementBlock(Item item) const { return item; }
+	Expr conditionExpr(Item item) const { return ast.first(item); }
+	Block ifClause(Item item) const { return ast.conditionIf(item); }
+	bool hasElse(Item item) const { return ast.conditionElse(item) != NO_NODE; }
+	Block elseClause(Item item) const { return ast.conditionElse(item); }
+
+	ExpressionKind kind(Expr node) const {
+		switch (ast.kind(node)) {
+		case NodeKind::INT: return ExpressionKind::INT;
+		case NodeKind::VARIABLE: return ExpressionKind::VARIABLE;
+		case NodeKind::UNARY: return ExpressionKind::UNARY;
+		case NodeKind::BINARY: return ExpressionKind::BINARY;
+		case NodeKind::ASSIGNMENT: return ExpressionKind::ASSIGNMENT;
+		default: throw std::runtime_error("Unsupported node!");
+		}
+	}
+	Expr first(Expr node) const { return ast.kind(node) == NodeKind::ASSIGNMENT ? ast.second(node) : ast.first(node); }
+	Expr second(Expr node) const { return ast.second(node); }
+	TokenType op(Expr node) const { return ast.op(node); }
+	int32_t literal(Expr node) const { return ast.literal(node); }
+	Symbol name(Expr node) const { return ast.name(node); }
+	uint32_t offset(Expr node) const { return ast.nameOffset(node); }
+};
+
+static IrOp unaryOp(TokenType op) {
+	switch (op) {
+	case TokenType::Negation: return IrOp::NEG;
+	case TokenType::BitwiseComplement: return IrOp::NOT;
+	case TokenType::LogicalNegation: return IrOp::LOGICAL_NOT;
+	default: throw std::runtime_error("Unsupported unary operator!");
+	}
+}
+
+static IrOp binaryOp(TokenType op) {
+	switch (op) {
+	case TokenType::Addition: return IrOp::ADD;
+	case TokenType::Negation: return IrOp::SUB;
+	case TokenType::Multiplication: return IrOp::MUL;
+	case TokenType::Division: return IrOp::DIV;
+	case TokenType::LogicalAnd: return IrOp::AND;
+	case TokenType::LogicalOr: return IrOp::OR;
+	case TokenType::Equal: return IrOp::EQ;
+	case TokenType::NotEqual: return IrOp::NE;
+	case TokenType::Less: return IrOp::LT;
+	case TokenType::Greater: return IrOp::GT;
+	default: throw std::runtime_error("Unsupported binary operator!");
+	}
+}
+
+typedef std::vector<std::pair<uint32_t, IrInstruction*>> VariableValues;
+
+// Builds SSA form as it walks the tree. The language has no loops, so every block has all
+// its predecessors by the time it is entered and values never have to be looked up later:
+// each variable's current value is simply kept, and the assignments made in a condition's
+// clauses are undone after each clause and merged at its end.
+template <class TTree>
+class Lowering {
+public:
+	Lowering(const TTree& _tree, IrFunction& _function, Diagnostics& _diagnostics)
+		: tree(_tree), function(_function), diagnostics(_diagnostics), current(nullptr), undefined(nullptr), conditionDepth(0), stamp(0) {};
+
+	void lower(typename TTree::Block body);
+private:
+	typedef typename TTree::Block Block;
+	typedef typename TTree::Item Item;
+	typedef typename TTree::Expr Expr;
+
+	// Variables are numbered in declaration order after the pseudo-variable holding the
+	// value of the last evaluated expression
+	static const uint32_t LAST_VALUE = 0;
+	static const uint32_t NO_VARIABLE = UINT32_MAX;
+
+	const TTree& tree;
+	IrFunction& function;
+	Diagnostics& diagnostics;
+	IrBlock* current;
+	IrInstruction* undefined;
+	std::vector<IrInstruction*> returns;
+
+	std::vector<IrInstruction*> values;
+	std::vector<std::unordered_map<Symbol, uint32_t>> scopes;
+	// Assignments made in conditions, as the variable and its previous value
+	VariableValues changes;
+	size_t conditionDepth;
+	// Scratch space for collecting changes, by variable
+	std::vector<uint32_t> stamps;
+	std::vector<IrInstruction*> pending;
+	uint32_t stamp;
+
+	// Explicit stacks of expression(): nodes still to lower, the second time once their
+	// operands are, and the values of the lowered operands
+	struct PendingNode {
+		Expr node;
+		bool operandsLowered;
+	};
+	std::vector<PendingNode> pendingNodes;
+	std::vector<IrInstruction*> operandValues;
+
+	void block(Block block);
+	void item(Item item);
+	void condition(Item item);
+	IrInstruction* expression(Expr node);
+	void returnValue(IrInstruction* value);
+
+	uint32_t declare(Symbol name, uint32_t offset);
+	uint32_t findVariable(Symbol name) const;
+	void assign(uint32_t variable, IrInstruction* value);
+	VariableValues undoChanges(size_t mark, uint32_t declared);
+	void merge(IrBlock* ifEnd, const VariableValues& ifValues, IrBlock* elseEnd, const VariableValues& elseValues);
+	void join(uint32_t variable, IrBlock* ifEnd, IrInstruction* ifValue, IrBlock* elseEnd, IrInstruction* elseValue);
+};
+
+template <class TTree>
+void Lowering<TTree>::lower(Block body) {
+	current = function.addBlock();
+	undefined = function.undefined(current);
+	values.push_back(undefined);
+	stamps.push_back(0);
+	pending.push_back(nullptr);
+
+	block(body);
+	returnValue(values[LAST_VALUE]);
+
+	IrBlock* exit = function.addBlock();
+	std::vector<IrPhiInput> inputs;
+	for (IrInstruction* jump : returns) {
+		jump->targets[0] = exit;
+		inputs.push_back({ jump->block, jump->operands[0] });
+		jump->operands[0] = nullptr;
+	}
+	function.ret(exit, function.phi(exit, inputs.data(), inputs.data() + inputs.size()));
+	function.computePredecessors();
+}
+
+// The jump to the exit block carries the value in its operand until the exit block exists
+template <class TTree>
+void Lowering<TTree>::returnValue(IrInstruction* value) {
+	IrInstruction* jump = function.jump(current, nullptr);
+	jump->operands[0] = value;
+	returns.push_back(jump);
+}
+
+template <class TTree>
+void Lowering<TTree>::block(Block block) {
+	scopes.emplace_back();
+	for (size_t i = 0; i < tree.itemCount(block); i++) {
+		item(tree.item(block, i));
+	}
+	scopes.pop_back();
+}
+
+template <class TTree>
+void Lowering<TTree>::item(Item item) {
+	switch (tree.itemKind(item)) {
+	case ItemKind::DECLARATION: {
+		// The variable is in scope in its own initializer
+		uint32_t variable = declare(tree.declaredName(item), tree.declaredOffset(item));
+		IrInstruction* value;
+		if (tree.initialized(item)) {
+			value = expression(tree.initializer(item));
+			assign(LAST_VALUE, value);
+		}
+		else {
+			value = function.constant(current, 0);
+		}
+		if (variable != NO_VARIABLE) {
+			assign(variable, value);
+		}
+		return;
+	}
+	case ItemKind::RETURN_STATEMENT:
+		returnValue(expression(tree.statementExpr(item)));
+		// Whatever follows can't run
+		current = function.addBlock();
+		return;
+	case ItemKind::EXPRESSION_STATEMENT:
+		assign(LAST_VALUE, expression(tree.statementExpr(item)));
+		return;
+	case ItemKind::BLOCK:
+		block(tree.statementBlock(item));
+		return;
+	case ItemKind::CONDITION:
+		condition(item);
+		return;
+	}
+}
+
+// The test branches to the if clause or to the else block, which is there even without an
+// else clause, so that no edge leads from a branch straight to a block with phis
+template <class TTree>
+void Lowering<TTree>::condition(Item item) {
+	IrInstruction* test = expression(tree.conditionExpr(item));
+	assign(LAST_VALUE, test);
+	IrInstruction* branch = function.branch(current, test, nullptr, nullptr);
+
+	size_t mark = changes.size();
+	uint32_t declared = uint32_t(values.size());
+	conditionDepth++;
+
+	branch->targets[0] = current = function.addBlock();
+	block(tree.ifClause(item));
+	IrBlock* ifEnd = current;
+	IrInstruction* ifJump = function.jump(ifEnd, nullptr);
+	VariableValues ifValues = undoChanges(mark, declared);
+
+	branch->targets[1] = current = function.addBlock();
+	if (tree.hasElse(item)) {
+		block(tree.elseClause(item));
+	}
+	IrBlock* elseEnd = current;
+	IrInstruction* elseJump = function.jump(elseEnd, nullptr);
+	VariableValues elseValues = undoChanges(mark, declared);
+
+	conditionDepth--;
+	current = function.addBlock();
+	ifJump->targets[0] = current;
+	elseJump->targets[0] = current;
+	merge(ifEnd, ifValues, elseEnd, elseValues);
+}
+
+// Post-order walk over explicit stacks, as parseExpression does, so that long operator
+// chains don't overflow the native stack. Operands are lowered left to right.
+template <class TTree>
+IrInstruction* Lowering<TTree>::expression(Expr root) {
+	pendingNodes.clear();
+	operandValues.clear();
+	pendingNodes.push_back({ root, false });
+
+	while (!pendingNodes.empty()) {
+		PendingNode next = pendingNodes.back();
+		pendingNodes.pop_back();
+		Expr node = next.node;
+
+		switch (tree.kind(node)) {
+		case ExpressionKind::INT:
+			operandValues.push_back(function.constant(current, tree.literal(node)));
+			break;
+		case ExpressionKind::VARIABLE: {
+			uint32_t variable = findVariable(tree.name(node));
+			if (variable == NO_VARIABLE) {
+				diagnostics.report(DiagnosticCode::UNDECLARED_VARIABLE, tree.offset(node));
+				operandValues.push_back(undefined);
+			}
+			else {
+				operandValues.push_back(values[variable]);
+			}
+			break;
+		}
+		case ExpressionKind::UNARY:
+			if (!next.operandsLowered) {
+				pendingNodes.push_back({ node, true });
+				pendingNodes.push_back({ tree.first(node), false });
+			}
+			else {
+				operandValues.back() = function.unary(current, unaryOp(tree.op(node)), operandValues.back());
+			}
+			break;
+		case ExpressionKind::BINARY:
+			if (!next.operandsLowered) {
+				pendingNodes.push_back({ node, true });
+				pendingNodes.push_back({ tree.second(node), false });
+				pendingNodes.push_back({ tree.first(node), false });
+			}
+			else {
+				IrInstruction* right = operandValues.back();
+				operandValues.pop_back();
+				operandValues.back() = function.binary(current, binaryOp(tree.op(node)), operandValues.back(), right);
+			}
+			break;
+		case ExpressionKind::ASSIGNMENT:
+			if (!next.operandsLowered) {
+				pendingNodes.push_back({ node, true });
+				pendingNodes.push_back({ tree.first(node), false });
+			}
+			else {
+				uint32_t variable = findVariable(tree.name(node));
+				if (variable == NO_VARIABLE) {
+					diagnostics.report(DiagnosticCode::UNDECLARED_VARIABLE, tree.offset(node));
+				}
+				else {
+					assign(variable, operandValues.back());
+				}
+			}
+			break;
+		}
+	}
+	return operandValues.back();
+}
+
+// The first declaration stays in effect
+template <class TTree>
+uint32_t Lowering<TTree>::declare(Symbol name, uint32_t offset) {
+	uint32_t variable = uint32_t(values.size());
+	if (!scopes.back().insert(std::make_pair(name, variable)).second) {
+		diagnostics.report(DiagnosticCode::REDECLARED_VARIABLE, offset);
+		return NO_VARIABLE;
+	}
+	values.push_back(undefined);
+	stamps.push_back(0);
+	pending.push_back(nullptr);
+	return variable;
+}
+
+template <class TTree>
+uint32_t Lowering<TTree>::findVariable(Symbol name) const {
+	for (size_t i = scopes.size(); i-- > 0;) {
+		auto found = scopes[i].find(name);
+		if (found != scopes[i].end()) {
+			return found->second;
+		}
+	}
+	return NO_VARIABLE;
+}
+
+template <class TTree>
+void Lowering<TTree>::assign(uint32_t variable, IrInstruction* value) {
+	if (conditionDepth > 0) {
+		changes.push_back(std::make_pair(variable, values[variable]));
+	}
+	values[variable] = value;
+}
+
+// Restores the values from before the changes since mark and returns the final values of
+// the variables changed that were declared before it
+template <class TTree>
+VariableValues Lowering<TTree>::undoChanges(size_t mark, uint32_t declared) {
+	VariableValues finals;
+	stamp++;
+	for (size_t i = changes.size(); i-- > mark;) {
+		uint32_t variable = changes[i].first;
+		if (variable < declared && stamps[variable] != stamp) {
+			stamps[variable] = stamp;
+			finals.push_back(std::make_pair(variable, values[variable]));
+		}
+		values[variable] = changes[i].second;
+	}
+	changes.resize(mark);
+	return finals;
+}
+
+template <class TTree>
+void Lowering<TTree>::merge(IrBlock* ifEnd, const VariableValues& ifValues, IrBlock* elseEnd, const VariableValues& elseValues) {
+	stamp++;
+	for (const auto& ifValue : ifValues) {
+		stamps[ifValue.first] = stamp;
+		pending[ifValue.first] = ifValue.second;
+	}
+	for (const auto& elseValue : elseValues) {
+		uint32_t variable = elseValue.first;
+		IrInstruction* ifValue = values[variable];
+		if (stamps[variable] == stamp) {
+			ifValue = pending[variable];
+			pending[variable] = nullptr;
+		}
+		join(variable, ifEnd, ifValue, elseEnd, elseValue.second);
+	}
+	for (const auto& ifValue : ifValues) {
+		if (pending[ifValue.first]) {
+			pending[ifValue.first] = nullptr;
+			join(ifValue.first, ifEnd, ifValue.second, elseEnd, values[ifValue.first]);
+		}
+	}
+}
+
+template <class TTree>
+void Lowering<TTree>::join(uint32_t variable, IrBlock* ifEnd, IrInstruction* ifValue, IrBlock* elseEnd, IrInstruction* elseValue) {
+	if (ifValue == elseValue) {
+		assign(variable, ifValue);
+		return;
+	}
+	IrPhiInput inputs[] = { { ifEnd, ifValue }, { elseEnd, elseValue } };
+	assign(variable, function.phi(current, inputs, inputs + 2));
+}
+
+void lowerFunction(const FunctionAST& function, IrFunction& ir, Diagnostics& diagnostics) {
+	ArenaTree tree;
+	Lowering<ArenaTree>(tree, ir, diagnostics).lower(function.block);
+}
+
+void lowerFunction(const FlatAST& ast, NodeIndex function, IrFunction& ir, Diagnostics& diagnostics) {
+	FlatTree tree{ ast };
+	Lowering<FlatTree>(tree, ir, diagnostics).lower(ast.second(function));
+}
\ No newline at end of file
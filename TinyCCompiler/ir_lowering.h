@@ -0,0 +1,19 @@
+#ifndef IR_LOWERING_H
+#define IR_LOWERING_H
+
+#include "ast.h"
+#include "flat_ast.h"
+#include "diagnostics.h"
+#include "ir.h"
+
+// Builds the SSA form of a function into an empty IrFunction, reporting undeclared and
+// redeclared variables. Variables become values, merged by phis after conditions.
+//
+// Return statements jump to a single exit block, where a phi merges the returned values.
+// Code after a return is lowered into blocks without predecessors, left for dead code
+// elimination. A function that ends without a return returns its last evaluated
+// expression, as it always has.
+void lowerFunction(const FunctionAST& function, IrFunction& ir, Diagnostics& diagnostics);
+void lowerFunction(const FlatAST& ast, NodeIndex function, IrFunction& ir, Diagnostics& diagnostics);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "ir_passes.h"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+void IrTimings::add(const char* stage, double seconds) {
+	for (auto& entry : stages) {
+		if (std::strcmp(entry.first, stage) == 0) {
+			entry.second += seconds;
+			return;
+		}
+	}
+	stages.push_back(std::make_pair(stage, seconds));
+}
+
+void IrTimings::append(const IrTimings& other) {
+	for (const auto& entry : other.stages) {
+		add(entry.first, entry.second);
+	}
+}
+
+void IrTimings::print(std::ostream& out) const {
+	double total = 0;
+	for (const auto& entry : stages) {
+		total += entry.second;
+	}
+	out << "IR pipeline time by stage:\n";
+	for (const auto& entry : stages) {
+		out << "  " << entry.first << ": " << entry.second * 1e3 << " ms\n";
+	}
+	out << "  total: " << total * 1e3 << " ms" << std::endl;
+}
+
+void IrPassManager::add(const char* name, Pass pass) {
+	passes.push_back(std::make_pair(name, pass));
+}
+
+void IrPassManager::run(IrFunction& function, IrTimings& timings) const {
+	for (const auto& pass : passes) {
+		auto start = std::chrono::steady_clock::now();
+		pass.second(function);
+		timings.add(pass.first, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		if (verify) {
+			check(function, pass.first);
+		}
+	}
+}
+
+IrPassManager IrPassManager::standard(bool verify) {
+	IrPassManager manager(verify);
+	manager.add("constant folding", foldConstants);
+	manager.add("dead code elimination", eliminateDeadCode);
+	return manager;
+}
+
+void IrPassManager::check(const IrFunction& function, const char* after) {
+	std::string error;
+	if (!verifyIr(function, error)) {
+		throw std::runtime_error(std::string("Invalid IR after ") + after + ": " + error);
+	}
+}
\ No newline at end of file
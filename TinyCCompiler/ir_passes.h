@@ -0,0 +1,51 @@
+#ifndef IR_PASSES_H
+#define IR_PASSES_H
+
+#include "ir.h"
+
+#include <ostream>
+#include <utility>
+#include <vector>
+
+// Time spent in each stage of the IR pipeline, summed over the functions of a compilation
+class IrTimings {
+public:
+	void add(const char* stage, double seconds);
+	void append(const IrTimings& other);
+	// One line per stage, in the order they first ran
+	void print(std::ostream& out) const;
+private:
+	std::vector<std::pair<const char*, double>> stages;
+};
+
+// The passes every function goes through between lowering and code generation, in order.
+// A pass returns whether it changed the function.
+class IrPassManager {
+public:
+	typedef bool (*Pass)(IrFunction& function);
+
+	// With verify, the IR is checked after every pass and a broken one throws
+	explicit IrPassManager(bool _verify = false) : verify(_verify) {};
+
+	void add(const char* name, Pass pass);
+	void run(IrFunction& function, IrTimings& timings) const;
+
+	// The pipeline of the compiler
+	static IrPassManager standard(bool verify);
+
+	// Throws with the verifier's message and after what the IR broke when it isn't valid
+	static void check(const IrFunction& function, const char* after);
+private:
+	bool verify;
+	std::vector<std::pair<const char*, Pass>> passes;
+};
+
+// Conditional constant propagation: folds operators and phis over constants, turns branches
+// on constants into jumps and drops the blocks that can no longer run
+bool foldConstants(IrFunction& function);
+
+// Removes the blocks control can't reach, such as code after a return, phis with a single
+// distinct input, values nothing uses, and jumps to blocks with no other predecessor
+bool eliminateDeadCode(IrFunction& function);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include "token.h"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+struct Keyword {
+	std::string_view word;
+	TokenType type;
+};
+
+// Perfect hash over a fixed keyword set, built at compile time. A lookup costs a
+// few arithmetic operations, one table load and one comparison against the
+// candidate slot, regardless of how many keywords there are.
+template <size_t N>
+class KeywordTable {
+public:
+	static constexpr uint32_t BITS = [] { uint32_t bits = 1; while ((size_t(1) << bits) < 4 * N) { bits++; } return bits; }();
+	static constexpr size_t SIZE = size_t(1) << BITS;
+
+	constexpr KeywordTable(const Keyword(&keywords)[N]) : seed(0), minLength(SIZE_MAX), maxLength(0), slots{} {
+		for (const Keyword& keyword : keywords) {
+			minLength = keyword.word.size() < minLength ? keyword.word.size() : minLength;
+			maxLength = keyword.word.size() > maxLength ? keyword.word.size() : maxLength;
+		}
+
+		// Seeds are tried until every keyword lands in its own slot
+		for (uint32_t candidate = 1; candidate < UINT32_MAX; candidate++) {
+			if (isCollisionFree(keywords, candidate)) { seed = candidate; break; }
+		}
+
+		for (const Keyword& keyword : keywords) {
+			slots[slot(keyword.word, seed)] = keyword;
+		}
+	}
+
+	constexpr TokenType find(std::string_view word) const {
+		if (word.size() < minLength || word.size() > maxLength) { return TokenType::FAILED; }
+
+		const Keyword& candidate = slots[slot(word, seed)];
+		return candidate.word == word ? candidate.type : TokenType::FAILED;
+	}
+
+	constexpr bool isValid() const { return seed != 0; }
+
+private:
+	uint32_t seed;
+	size_t minLength, maxLength;
+	std::array<Keyword, SIZE> slots;
+
+	// Packs the length with the first, middle and last characters; keywords must differ in one of them
+	static constexpr size_t slot(std::string_view word, uint32_t seed) {
+		uint32_t key = uint32_t(word.size()) << 24 | uint32_t(uint8_t(word.front())) << 16
+			| uint32_t(uint8_t(word[word.size() / 2])) << 8 | uint8_t(word.back());
+		uint32_t hash = (key ^ seed) * 0x9E3779B1u;
+		hash ^= hash >> 15;
+		hash *= 0x85EBCA77u;
+		return size_t(hash >> (32 - BITS));
+	}
+
+	static constexpr bool isCollisionFree(const Keyword(&keywords)[N], uint32_t seed) {
+		bool used[SIZE] = {};
+		for (const Keyword& keyword : keywords) {
+			size_t index = slot(keyword.word, seed);
+			if (used[index]) { return false; }
+			used[index] = true;
+		}
+		return true;
+	}
+};
+
+template <size_t N>
+constexpr KeywordTable<N> makeKeywordTable(const Keyword(&keywords)[N]) {
+	return KeywordTable<N>(keywords);
+}
+
+constexpr Keyword KEYWORDS[] = {
+	{ "int", TokenType::IntType },
+	{ "float", TokenType::FloatType },
+	{ "return", TokenType::ReturnKeyword },
+	{ "if", TokenType::IfOperator },
+	{ "else", TokenType::ElseOperator },
+};
+
+constexpr auto KEYWORD_TABLE = makeKeywordTable(KEYWORDS);
+static_assert(KEYWORD_TABLE.isValid(), "No perfect hash found for the keyword set");
+
+// Returns the keyword token type for an identifier, or FAILED if it is not a keyword.
+inline TokenType classifyKeyword(std::string_view word) {
+	return KEYWORD_TABLE.find(word);
+}
+
+#endif
\ No newline at end of file
@@ -1,121 +1,129 @@
 #include "lexer.h"
+#include "keywords.h"
+#include "simd_scan.h"
 
+#include <charconv>
 #include <stdexcept>
 
-Lexer::Lexer(std::string _inputString) : inputString(_inputString) {
+Lexer::Lexer(std::string_view _inputString, StringInterner* _symbols) : inputString(_inputString), symbols(_symbols) {
 	itCurrent = inputString.cbegin();
 	itLexemeBegin = itCurrent;
-	itStartOfLine = itLexemeBegin;
-	line = 0;
 };
 
 void Lexer::next() {
-	if (*itCurrent == '\n') {
-		line++;
-		itStartOfLine = itCurrent + 1;
-	}
 	++itCurrent;
 }
 
-void Lexer::moveLexemeBegin() {
-	++itLexemeBegin;
+void Lexer::skipTo(const char* position) {
+	itCurrent = inputString.cbegin() + (position - inputString.data());
 }
 
-bool Lexer::skipChar() {
-	return *itCurrent == ' ' || *itCurrent == '\n' || *itCurrent == '\r' || *itCurrent == '\t';
+const char* Lexer::currentPointer() {
+	return inputString.data() + (itCurrent - inputString.cbegin());
 }
 
-Token Lexer::getNextToken() {
+CompactToken Lexer::getNextToken() {
 	while (itCurrent != inputString.cend()) {
-		while (!endIsReached() && skipChar()) { next(); moveLexemeBegin();  }
+		skipTo(scanKernels().skipWhitespace(currentPointer(), inputString.data() + inputString.size()));
+		itLexemeBegin = itCurrent;
 		if (endIsReached()) { break; }
 
 		if (*itCurrent >= 'a' && *itCurrent <= 'z' || *itCurrent >= 'A' && *itCurrent <= 'Z') {
-			 Token token = identifier();
-			 Token keyword = classifyKeyword(token.begin, token.end);
-			 if (keyword != FAILED()) { token = keyword; }
+			 CompactToken token = identifier();
+			 TokenType keyword = classifyKeyword(itLexemeBegin, itCurrent);
+			 if (keyword != TokenType::FAILED) { token.type = keyword; }
+			 else if (symbols) { token.symbol = symbols->intern(inputString.substr(token.offset, token.length)); }
 			 itLexemeBegin = itCurrent;
 			 return token;
 		}
 		if (*itCurrent == '0') {
-			Token floatValToken = getFloatNumber();
-			if (floatValToken != FAILED()) {
+			CompactToken floatValToken = getFloatNumber();
+			if (floatValToken.type != TokenType::FAILED) {
 				itLexemeBegin = itCurrent;
 				return floatValToken;
 			}
 
 			itCurrent = itLexemeBegin;
-			Token intValToken = getIntBinaryNumber();
-			if (intValToken != FAILED()) {
+			CompactToken intValToken = getIntBinaryNumber();
+			if (intValToken.type != TokenType::FAILED) {
 				itLexemeBegin = itCurrent;
 				return intValToken;
 			}
 
 			itCurrent = itLexemeBegin;
 			intValToken = getIntDecimalNumber();
-			if (intValToken != FAILED()) {
+			if (intValToken.type != TokenType::FAILED) {
 				itLexemeBegin = itCurrent;
 				return intValToken;
 			}
 		}
 		if (*itCurrent >= '1' && *itCurrent <= '9') {
-			Token floatValToken = getFloatNumber();
-			if (floatValToken != FAILED()) {
+			CompactToken floatValToken = getFloatNumber();
+			if (floatValToken.type != TokenType::FAILED) {
 				itLexemeBegin = itCurrent;
 				return floatValToken;
 			}
 
 			itCurrent = itLexemeBegin;
-			Token intValToken = getIntDecimalNumber();
-			if (intValToken != FAILED()) {
+			CompactToken intValToken = getIntDecimalNumber();
+			if (intValToken.type != TokenType::FAILED) {
 				itLexemeBegin = itCurrent;
 				return intValToken;
 			}
 		}
 
 		itCurrent = itLexemeBegin;
-		Token bracket = getBracket();
-		if (bracket != FAILED()) { next(); itLexemeBegin = itCurrent; return bracket; }
+		CompactToken bracket = getBracket();
+		if (bracket.type != TokenType::FAILED) { itLexemeBegin = itCurrent; return bracket; }
 
 		itCurrent = itLexemeBegin;
-		Token semicolon = getSemicolon();
-		if (semicolon != FAILED()) { next(); itLexemeBegin = itCurrent; return semicolon; }
+		CompactToken semicolon = getSemicolon();
+		if (semicolon.type != TokenType::FAILED) { itLexemeBegin = itCurrent; return semicolon; }
 
 		itCurrent = itLexemeBegin;
-		Token unaryOperator = getUnaryOperator();
-		if (unaryOperator != FAILED()) { next(); itLexemeBegin = itCurrent; return unaryOperator; }
+		CompactToken unaryOperator = getUnaryOperator();
+		if (unaryOperator.type != TokenType::FAILED) { itLexemeBegin = itCurrent; return unaryOperator; }
 
 		itCurrent = itLexemeBegin;
-		Token binaryOperator = getBinaryOperator();
-		if (binaryOperator != FAILED()) { next(); itLexemeBegin = itCurrent; return binaryOperator; }
+		CompactToken binaryOperator = getBinaryOperator();
+		if (binaryOperator.type != TokenType::FAILED) { itLexemeBegin = itCurrent; return binaryOperator; }
 
 		itCurrent = itLexemeBegin;
-		Token assignment = parseEquals();
-		if (assignment != FAILED()) { next(); itLexemeBegin = itCurrent; return assignment; }
+		CompactToken assignment = parseEquals();
+		if (assignment.type != TokenType::FAILED) { itLexemeBegin = itCurrent; return assignment; }
 
-		return FAILED();
+		// Consume the offending character so that the caller can report it and move on
+		itCurrent = itLexemeBegin;
+		next();
+		CompactToken failed = FAILED();
+		itLexemeBegin = itCurrent;
+		return failed;
 	}
 
-	return Token(TokenType::End, inputString.cend(), inputString.cend(), "\0", inputString.cend() - itStartOfLine, line);
+	return makeToken(TokenType::End, inputString.cend());
 }
 
-Token Lexer::identifier() {
+CompactToken Lexer::identifier() {
 	next();
-	while (!endIsReached() && *itCurrent >= 'a' && *itCurrent <= 'z' || *itCurrent >= 'A' && *itCurrent <= 'Z' || *itCurrent == '_' || *itCurrent >= '0' && *itCurrent <= '9') { next(); }
+	skipTo(scanKernels().skipIdentifier(currentPointer(), inputString.data() + inputString.size()));
 
-	std::string lexeme = std::string(itLexemeBegin, itCurrent);
-	return Token(TokenType::Identifier, itLexemeBegin, itCurrent, lexeme, itLexemeBegin - itStartOfLine, line);
+	return makeToken(TokenType::Identifier, itCurrent);
 }
 
-Token Lexer::getIntDecimalNumber() {
+CompactToken Lexer::getIntDecimalNumber() {
 	next();
-	while (!endIsReached() && *itCurrent >= '0' && *itCurrent <= '9') { next(); }
+	skipTo(scanKernels().skipDigits(currentPointer(), inputString.data() + inputString.size()));
 
-	std::string lexeme = std::string(itLexemeBegin, itCurrent);
-	return Token(TokenType::IntValue, itLexemeBegin, itCurrent, lexeme, std::stoi(lexeme), itLexemeBegin - itStartOfLine, line);
+	int32_t intVal = 0;
+	auto result = std::from_chars(&*itLexemeBegin, &*itLexemeBegin + (itCurrent - itLexemeBegin), intVal);
+
+	CompactToken token = makeToken(TokenType::IntValue, itCurrent);
+	token.intVal = intVal;
+	token.outOfRange = result.ec == std::errc::result_out_of_range;
+	return token;
 }
 
-Token Lexer::getIntBinaryNumber() {
+CompactToken Lexer::getIntBinaryNumber() {
 	next();
 	if (!endIsReached() && *itCurrent == 'b') { next(); }
 	else { return FAILED(); }
@@ -125,13 +133,16 @@ Token Lexer::getIntBinaryNumber() {
 
 	while (!endIsReached() && (*itCurrent == '0' || *itCurrent == '1')) { next(); }
 
-	std::string lexeme = std::string(itLexemeBegin, itCurrent);
-	int intVal = std::stoi(std::string(itLexemeBegin + 2, itCurrent), nullptr, 2);
+	int32_t intVal = 0;
+	auto result = std::from_chars(&*itLexemeBegin + 2, &*itLexemeBegin + (itCurrent - itLexemeBegin), intVal, 2);
 
-	return Token(TokenType::IntValue, itLexemeBegin, itCurrent, lexeme, intVal, itLexemeBegin - itStartOfLine, line);
+	CompactToken token = makeToken(TokenType::IntValue, itCurrent);
+	token.intVal = intVal;
+	token.outOfRange = result.ec == std::errc::result_out_of_range;
+	return token;
 }
 
-Token Lexer::getFloatNumber()
+CompactToken Lexer::getFloatNumber()
 {
 	bool dot = false;
 	bool leadingZero = (*itCurrent == '0');
@@ -144,107 +155,108 @@ Token Lexer::getFloatNumber()
 	}
 
 	if (!dot) { return FAILED(); }
-	std::string lexeme = std::string(itLexemeBegin, itCurrent);
-	float floatVal = std::stof(lexeme);
-	return Token(TokenType::FloatValue, itLexemeBegin, itCurrent, lexeme, floatVal, itLexemeBegin - itStartOfLine, line);
+	// Like stof, the value is read from the digits before any second dot
+	float floatVal = 0;
+	auto result = std::from_chars(&*itLexemeBegin, &*itLexemeBegin + (itCurrent - itLexemeBegin), floatVal);
+
+	CompactToken token = makeToken(TokenType::FloatValue, itCurrent);
+	token.outOfRange = result.ec == std::errc::result_out_of_range;
+	token.floatVal = token.outOfRange ? 0 : floatVal;
+	return token;
 }
 
-Token Lexer::classifyKeyword(std::string::const_iterator begin, std::string::const_iterator end) {
-	std::string str(begin, end);
-
-	if (str == "int") { return Token(TokenType::IntType, begin, end, str, begin - itStartOfLine, line); }
-	if (str == "float") { return Token(TokenType::FloatType, begin, end, str, begin - itStartOfLine, line); }
-	if (str == "return") { return Token(TokenType::ReturnKeyword, begin, end, str, begin - itStartOfLine, line); }
-	if (str == "if") { return Token(TokenType::IfOperator, begin, end, str, begin - itStartOfLine, line); }
-	if (str == "else") { return Token(TokenType::ElseOperator, begin, end, str, begin - itStartOfLine, line); }
-
-	return FAILED();
+TokenType Lexer::classifyKeyword(std::string_view::const_iterator begin, std::string_view::const_iterator end) {
+	return ::classifyKeyword(std::string_view(&*begin, end - begin));
 }
 
-Token Lexer::getBracket() {
+CompactToken Lexer::getBracket() {
 	switch (*itCurrent) {
 	case '(':
-		return Token(TokenType::OpenParenthese, itLexemeBegin + 1, itCurrent, "(", itLexemeBegin + 1 - itStartOfLine, line);
+		return makeToken(TokenType::OpenParenthese, ++itCurrent);
 	case ')':
-		return Token(TokenType::CloseParenthese , itLexemeBegin + 1, itCurrent, ")", itLexemeBegin + 1 - itStartOfLine, line);
+		return makeToken(TokenType::CloseParenthese, ++itCurrent);
 	case '{':
-		return Token(TokenType::OpenBrace, itLexemeBegin, itCurrent + 1, "{", itLexemeBegin + 1 - itStartOfLine, line);
+		return makeToken(TokenType::OpenBrace, ++itCurrent);
 	case '}':
-		return Token(TokenType::CloseBrace, itLexemeBegin, itCurrent + 1, "}", itLexemeBegin + 1 - itStartOfLine, line);
+		return makeToken(TokenType::CloseBrace, ++itCurrent);
 	default:
 		return FAILED();
 	}
 }
 
-Token Lexer::getOperator() {
+CompactToken Lexer::getOperator() {
 	return FAILED();
 }
 
-Token Lexer::getSemicolon()
+CompactToken Lexer::getSemicolon()
 {
-	if (*itCurrent == ';') { return Token(TokenType::Semicolon, itLexemeBegin, itCurrent + 1, ";", itLexemeBegin - itStartOfLine, line); }
+	if (*itCurrent == ';') { return makeToken(TokenType::Semicolon, ++itCurrent); }
 
 	return FAILED();
 }
 
-Token Lexer::getUnaryOperator()
+CompactToken Lexer::getUnaryOperator()
 {
 	switch (*itCurrent) {
 	case '~':
-		return Token(TokenType::BitwiseComplement, itLexemeBegin, itCurrent + 1, "~", itLexemeBegin - itStartOfLine, line);
+		return makeToken(TokenType::BitwiseComplement, ++itCurrent);
 	case '-':
-		return Token(TokenType::Negation, itLexemeBegin, itCurrent + 1, "-", itLexemeBegin - itStartOfLine, line);
+		return makeToken(TokenType::Negation, ++itCurrent);
 	case '!':
-		return Token(TokenType::LogicalNegation, itLexemeBegin, itCurrent + 1, "!", itLexemeBegin - itStartOfLine, line);
+		return makeToken(TokenType::LogicalNegation, ++itCurrent);
 	}
 
 	return FAILED();
 }
 
-Token Lexer::getBinaryOperator()
+CompactToken Lexer::getBinaryOperator()
 {
 
 	switch (*itCurrent) {
 	case '+':
-		return Token(TokenType::Addition, itLexemeBegin, itCurrent + 1, "+", itLexemeBegin - itStartOfLine, line);
+		return makeToken(TokenType::Addition, ++itCurrent);
 	case '*':
-		return Token(TokenType::Multiplication, itLexemeBegin, itCurrent + 1, "*", itLexemeBegin - itStartOfLine, line);
+		return makeToken(TokenType::Multiplication, ++itCurrent);
 	case '/':
-		return Token(TokenType::Division, itLexemeBegin, itCurrent + 1, "/", itLexemeBegin - itStartOfLine, line);
+		return makeToken(TokenType::Division, ++itCurrent);
 	case '<':
-		return Token(TokenType::Less, itLexemeBegin, itCurrent + 1, "<", itLexemeBegin - itStartOfLine, line);
+		return makeToken(TokenType::Less, ++itCurrent);
 	case '>':
-		return Token(TokenType::Greater, itLexemeBegin, itCurrent + 1, ">", itLexemeBegin - itStartOfLine, line);
+		return makeToken(TokenType::Greater, ++itCurrent);
 	}
 
-	if (std::string(itCurrent, itCurrent + 2).compare("&&") == 0) {
+	if (inputString.cend() - itCurrent >= 2 && *itCurrent == '&' && *(itCurrent + 1) == '&') {
 		itCurrent += 2;
-		return Token(TokenType::LogicalAnd, itLexemeBegin, itCurrent + 2, "&&", itLexemeBegin - itStartOfLine, line);
+		return makeToken(TokenType::LogicalAnd, itCurrent);
 	}
 
-	if (std::string(itCurrent, itCurrent + 2).compare("||") == 0) {
+	if (inputString.cend() - itCurrent >= 2 && *itCurrent == '|' && *(itCurrent + 1) == '|') {
 		itCurrent += 2;
-		return Token(TokenType::LogicalOr, itLexemeBegin, itCurrent + 2, "||", itLexemeBegin - itStartOfLine, line);
+		return makeToken(TokenType::LogicalOr, itCurrent);
 	}
 
 	return FAILED();
 }
 
-Token Lexer::parseEquals()
+CompactToken Lexer::parseEquals()
 {
 	if (*itCurrent == '=') {
 		if (itCurrent + 1 != inputString.end() && *(itCurrent + 1) == '=') {
-			next();
-			return Token(TokenType::Equal, itLexemeBegin, itCurrent, "==", itLexemeBegin - itStartOfLine, line);
+			itCurrent += 2;
+			return makeToken(TokenType::Equal, itCurrent);
 		}
-		return Token(TokenType::Assignment, itLexemeBegin, itCurrent + 1, "=", itLexemeBegin - itStartOfLine, line);
+		return makeToken(TokenType::Assignment, ++itCurrent);
 	}
 
 	return FAILED();
 }
 
-Token Lexer::FAILED() {
-	return Token(TokenType::FAILED, itLexemeBegin, itCurrent, std::string(itLexemeBegin, itCurrent), itLexemeBegin - itStartOfLine, line);
+CompactToken Lexer::makeToken(TokenType type, std::string_view::const_iterator end) {
+	return CompactToken(type, uint32_t(itLexemeBegin - inputString.cbegin()), uint32_t(end - itLexemeBegin));
+}
+
+CompactToken Lexer::FAILED() {
+	return makeToken(TokenType::FAILED, itCurrent);
 }
 
 bool Lexer::endIsReached() {
@@ -2,36 +2,39 @@
 #define LEXER_H
 
 #include "token.h"
+#include "string_interner.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
+// Trial-and-rewind lexer kept for comparison with DfaLexer. The source must outlive the lexer.
 class Lexer {
 public:
-	Lexer(std::string inputString);
-	Token getNextToken();
+	Lexer(std::string_view inputString, StringInterner* symbols = nullptr);
+	CompactToken getNextToken();
 private:
-	std::string inputString;
-	std::string::const_iterator itLexemeBegin;
-	std::string::const_iterator itCurrent;
-	std::string::const_iterator itStartOfLine;
-	int line;
+	std::string_view inputString;
+	StringInterner* symbols;
+	std::string_view::const_iterator itLexemeBegin;
+	std::string_view::const_iterator itCurrent;
 
 	void next();
-	void moveLexemeBegin();
-	bool skipChar();
-	Token identifier();
-	Token getIntDecimalNumber();
-	Token getIntBinaryNumber();
-	Token getFloatNumber();
-	Token getBracket();
-	Token getOperator();
-	Token getSemicolon();
-	Token getUnaryOperator();
-	Token getBinaryOperator();
-	Token parseEquals();
-	Token classifyKeyword(std::string::const_iterator, std::string::const_iterator);
-	Token FAILED();
+	void skipTo(const char* position);
+	const char* currentPointer();
+	CompactToken identifier();
+	CompactToken getIntDecimalNumber();
+	CompactToken getIntBinaryNumber();
+	CompactToken getFloatNumber();
+	CompactToken getBracket();
+	CompactToken getOperator();
+	CompactToken getSemicolon();
+	CompactToken getUnaryOperator();
+	CompactToken getBinaryOperator();
+	CompactToken parseEquals();
+	TokenType classifyKeyword(std::string_view::const_iterator, std::string_view::const_iterator);
+	CompactToken makeToken(TokenType type, std::string_view::const_iterator end);
+	CompactToken FAILED();
 	bool endIsReached();
 };
 
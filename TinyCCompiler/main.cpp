@@ -1,67 +1,233 @@
 #include "token.h"
+#include "token_stream.h"
 #include "lexer.h"
-#include "parser.h"
-#include "code_generator.h"
+#include "dfa_lexer.h"
+#include "compiler.h"
+#include "compile_server.h"
+#include "compile_cache.h"
+#include "incremental_compiler.h"
+#include "benchmark.h"
+#include "source_file.h"
+#include "parallel_lexer.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <memory>
 #include <stdio.h>
 #include <string>
+#include <vector>
 #include <exception>
 
+void printToken(const TokenSource& tokens, const CompactToken& token) {
+	std::cout << tokenTypeToString(token.type) << " | " << tokens.lexeme(token) << std::endl;
+}
+
+template <class TLexer>
+void tokenize(TLexer& lexer, TokenStream& tokens) {
+	CompactToken token;
+	while ((token = lexer.getNextToken()).type != TokenType::End) {
+		printToken(tokens, token);
+		tokens.push_back(token);
+	};
+	tokens.push_back(token);
+}
+
 int main(int argc, char* argv[]) {
 	std::string filename = "code.c";
 	std::string outputFile = "code.asm";
+	CompileOptions options;
+	int jobs = 1;
+	bool batch = false;
+	std::vector<std::string> batchFiles;
+	std::string serverSocket;
+	std::string clientSocket;
+	std::string cacheDirectory;
+	std::string incrementalState;
+	uint64_t cacheBytes = uint64_t(256) << 20;
 
-	if (argc > 1) {
-		filename = argv[1];
-
-		if (argc == 4) {
-			if (std::strcmp(argv[2], "-o") == 0) {
-				outputFile = argv[3];
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			outputFile = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--legacy-lexer") == 0) {
+			options.legacyLexer = true;
+		}
+		else if (std::strcmp(argv[i], "--stream") == 0) {
+			options.streaming = true;
+		}
+		else if (std::strcmp(argv[i], "--flat-ast") == 0) {
+			options.flatAst = true;
+		}
+		else if (std::strcmp(argv[i], "--recursive-expressions") == 0) {
+			options.expressionParsing = ExpressionParsing::RECURSIVE_DESCENT;
+		}
+		else if (std::strcmp(argv[i], "--verify-ir") == 0) {
+			options.verifyIr = true;
+		}
+		else if (std::strcmp(argv[i], "--dump-ir") == 0) {
+			options.dumpIr = true;
+		}
+		else if (std::strcmp(argv[i], "--time-passes") == 0) {
+			options.timePasses = true;
+		}
+		else if (std::strcmp(argv[i], "--peephole-stats") == 0) {
+			options.peepholeStats = true;
+		}
+		else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			jobs = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--batch") == 0) {
+			batch = true;
+		}
+		else if (std::strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+			serverSocket = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--client") == 0 && i + 1 < argc) {
+			clientSocket = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+			cacheDirectory = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+			cacheBytes = uint64_t(std::max(1, std::atoi(argv[++i]))) << 20;
+		}
+		else if (std::strcmp(argv[i], "--incremental") == 0 && i + 1 < argc) {
+			incrementalState = argv[++i];
+		}
+		else if (argv[i][0] == '@') {
+			if (!readResponseFile(argv[i] + 1, batchFiles)) {
+				std::cout << "Wrong response filename!" << std::endl;
+				return -1;
 			}
 		}
+		else if (std::strcmp(argv[i], "--verify-parallel-lexer") == 0) {
+			return runParallelLexerCheck(std::cout);
+		}
+		else if (std::strcmp(argv[i], "--verify-incremental-lexer") == 0) {
+			return runIncrementalLexerCheck(std::cout);
+		}
+		else if (std::strcmp(argv[i], "--verify-server") == 0 && i + 1 < argc) {
+			return runServerCheck(argv[i + 1], std::cout);
+		}
+		else if (std::strcmp(argv[i], "--bench-keywords") == 0) {
+			runKeywordBenchmark(std::cout);
+			return 0;
+		}
+		else if (std::strcmp(argv[i], "--bench") == 0) {
+			return runPipelineBenchmark(argc - i - 1, argv + i + 1, std::cout);
+		}
+		else {
+			filename = argv[i];
+			batchFiles.push_back(filename);
+		}
 	}
 
-	std::ifstream input(filename, std::ifstream::binary);
-	std::string inputString((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
-
-	Lexer lexer(inputString);
-	Token token;
-	std::vector<Token> tokens;
-	while ((token = lexer.getNextToken()).type != TokenType::End) {
-		std::cout << token << std::endl;
-		tokens.push_back(token);
-	};
-	tokens.push_back(token);
+	if (!serverSocket.empty()) {
+		return runServer(serverSocket, std::cout);
+	}
+	if (!clientSocket.empty()) {
+		return runClient(clientSocket, filename, outputFile, options, std::cout);
+	}
 
-	std::cout << std::endl;
+	// The incremental state plays the part of the cache there
+	if (!incrementalState.empty() && !cacheDirectory.empty()) {
+		std::cout << "--incremental can't be combined with --cache!" << std::endl;
+		return -1;
+	}
 
-	Parser parser(tokens);
-	auto ast = parser.Parse();
-	if (ast) {
-		CodeGenerator codeGen;
-		std::ofstream out(outputFile);
-		if (!out.is_open()) {
-			std::cout << "Wrong output filename!" << std::endl;
+	std::unique_ptr<CompileCache> cache;
+	if (!cacheDirectory.empty()) {
+		cache.reset(new CompileCache(cacheDirectory, cacheBytes));
+		if (!cache->open()) {
+			std::cout << "Wrong cache directory!" << std::endl;
 			return -1;
 		}
+	}
+
+	// Every input file is compiled to an .asm file next to it
+	if (batch) {
+		int status = compileBatch(batchFiles, options, size_t(jobs), cache.get(), std::cout);
+		if (cache) { cache->printStatistics(std::cout); }
+		return status;
+	}
+
+	SourceFile input;
+	if (!input.open(filename)) {
+		std::cout << "Wrong input filename!" << std::endl;
+		return -1;
+	}
+	std::string_view inputString = input.contents();
+
+	// A cached result is written as is, without lexing, parsing or generating anything
+	std::string cacheKey;
+	if (cache) {
+		cacheKey = cache->key(inputString, options);
+		std::string code;
+		if (cache->lookup(cacheKey, code)) {
+			int status = writeOutputFile(outputFile, code, std::cout) ? 0 : -1;
+			cache->printStatistics(std::cout);
+			return status;
+		}
+	}
+
+	StringInterner symbols;
+	// Shared by the lexer and the per-function code generation
+	std::unique_ptr<ThreadPool> pool;
+	if (jobs > 1) {
+		pool.reset(new ThreadPool(jobs));
+	}
+
+	// Unchanged functions are taken from the state of the previous build
+	if (!incrementalState.empty()) {
+		return compileIncrementally(inputString, incrementalState, outputFile, options, pool.get(), std::cout);
+	}
 
-		try {
-			out << codeGen.generateCode(*ast);
+	auto compileTokens = [&](TokenSource& tokens) {
+		if (!cache) {
+			return compile(tokens, symbols, pool.get(), outputFile, options, std::cout);
 		}
-		catch (std::runtime_error err) {
-			std::cout << err.what() << std::endl;
+
+		std::string code;
+		int status = compile(tokens, symbols, pool.get(), options, code, std::cout);
+		if (status == 0) {
+			if (!writeOutputFile(outputFile, code, std::cout)) { return -1; }
+			cache->store(cacheKey, code);
 		}
-		out.close();
+		cache->printStatistics(std::cout);
+		return status;
+	};
+
+	// Tokens are pulled by the parser as it goes, so only the mapped source stays in memory
+	if (options.streaming) {
+		if (options.legacyLexer) {
+			Lexer lexer(inputString, &symbols);
+			TokenWindow<Lexer> tokens(lexer, inputString);
+			return compileTokens(tokens);
+		}
+		DfaLexer lexer(inputString, &symbols);
+		TokenWindow<DfaLexer> tokens(lexer, inputString);
+		return compileTokens(tokens);
 	}
-	else {
-		auto errors = parser.GetErrors();
-		for (auto error : errors) {
-			std::cout << error->getMessage() << std::endl;
+
+	TokenStream tokens(inputString);
+	if (jobs > 1 && !options.legacyLexer) {
+		lexInParallel(inputString, &symbols, tokens, *pool);
+		for (size_t i = 0; i + 1 < tokens.size(); i++) {
+			printToken(tokens, tokens[i]);
 		}
 	}
+	else if (options.legacyLexer) {
+		Lexer lexer(inputString, &symbols);
+		tokenize(lexer, tokens);
+	}
+	else {
+		DfaLexer lexer(inputString, &symbols);
+		tokenize(lexer, tokens);
+	}
 
-	input.close();
+	std::cout << std::endl;
 
-	return 0;
+	return compileTokens(tokens);
 }
\ No newline at end of file
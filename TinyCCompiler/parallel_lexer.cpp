@@ -0,0 +1,89 @@
+#include "parallel_lexer.h"
+#include "dfa_lexer.h"
+#include "simd_scan.h"
+
+#include <algorithm>
+
+struct LexedChunk {
+	uint32_t begin, end;
+	std::vector<CompactToken> tokens;
+	StringInterner symbols;      // Chunk-local symbols, renumbered when chunks are merged
+	std::vector<Symbol> globalSymbols;
+	size_t newlineCount;
+	size_t firstToken, firstLine;
+};
+
+static std::vector<LexedChunk> splitAtNewlines(std::string_view source, size_t chunkBytes) {
+	std::vector<LexedChunk> chunks;
+	size_t begin = 0;
+	while (begin < source.size()) {
+		size_t end = std::min(begin + chunkBytes, source.size());
+		if (end < source.size()) {
+			size_t newline = source.find('\n', end - 1);
+			end = newline == std::string_view::npos ? source.size() : newline + 1;
+		}
+
+		chunks.emplace_back();
+		chunks.back().begin = uint32_t(begin);
+		chunks.back().end = uint32_t(end);
+		begin = end;
+	}
+	return chunks;
+}
+
+void lexInParallel(std::string_view source, StringInterner* symbols, TokenStream& tokens, ThreadPool& pool, size_t minChunkBytes) {
+	// A few chunks per worker keep the pool busy when chunks differ in token density
+	size_t chunkBytes = std::max(minChunkBytes, source.size() / (pool.size() * 4) + 1);
+	std::vector<LexedChunk> chunks = splitAtNewlines(source, chunkBytes);
+
+	pool.parallelFor(chunks.size(), [&](size_t i) {
+		LexedChunk& chunk = chunks[i];
+		std::string_view text = source.substr(chunk.begin, chunk.end - chunk.begin);
+		DfaLexer lexer(text, symbols ? &chunk.symbols : nullptr);
+
+		CompactToken token;
+		while ((token = lexer.getNextToken()).type != TokenType::End) {
+			token.offset += chunk.begin;
+			chunk.tokens.push_back(token);
+		}
+		chunk.newlineCount = scanKernels().countNewlines(text.data(), text.data() + text.size());
+	});
+
+	// Interning chunk by chunk assigns global symbols in order of first occurrence, as the serial lexer does
+	size_t tokenCount = 0, lineCount = 1;
+	for (LexedChunk& chunk : chunks) {
+		if (symbols) {
+			chunk.globalSymbols.resize(chunk.symbols.size());
+			for (Symbol symbol = 0; symbol < chunk.symbols.size(); symbol++) {
+				chunk.globalSymbols[symbol] = symbols->intern(chunk.symbols.name(symbol));
+			}
+		}
+
+		chunk.firstToken = tokenCount;
+		chunk.firstLine = lineCount;
+		tokenCount += chunk.tokens.size();
+		lineCount += chunk.newlineCount;
+	}
+
+	std::vector<CompactToken>& output = tokens.getTokens();
+	output.resize(tokenCount + 1);
+	std::vector<uint32_t> lineStarts(lineCount);
+	lineStarts[0] = 0;
+
+	pool.parallelFor(chunks.size(), [&](size_t i) {
+		LexedChunk& chunk = chunks[i];
+		CompactToken* destination = output.data() + chunk.firstToken;
+		for (CompactToken token : chunk.tokens) {
+			if (symbols && token.type == TokenType::Identifier) { token.symbol = chunk.globalSymbols[token.symbol]; }
+			*destination++ = token;
+		}
+
+		size_t line = chunk.firstLine;
+		for (size_t newline = source.find('\n', chunk.begin); newline < chunk.end; newline = source.find('\n', newline + 1)) {
+			lineStarts[line++] = uint32_t(newline + 1);
+		}
+	});
+
+	output[tokenCount] = CompactToken(TokenType::End, uint32_t(source.size()), 0);
+	tokens.setLineStarts(std::move(lineStarts));
+}
\ No newline at end of file
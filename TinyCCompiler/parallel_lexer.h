@@ -0,0 +1,15 @@
+#ifndef PARALLEL_LEXER_H
+#define PARALLEL_LEXER_H
+
+#include "token_stream.h"
+#include "string_interner.h"
+#include "thread_pool.h"
+
+#include <string_view>
+
+// Lexes the source in chunks on the thread pool. Chunks are split right after
+// newlines, which no token can span, so the resulting tokens, symbols and line
+// table are identical to a serial run of DfaLexer over the whole source.
+void lexInParallel(std::string_view source, StringInterner* symbols, TokenStream& tokens, ThreadPool& pool, size_t minChunkBytes = 256 * 1024);
+
+#endif
\ No newline at end of file
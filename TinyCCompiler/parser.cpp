@@ -1,64 +1,105 @@
 #include "parser.h"
 
-std::unique_ptr<ProgramAST> Parser::Parse()
+template <class TBuilder>
+auto BasicParser<TBuilder>::Parse() -> Program
 {
 	return parseProgram();
 }
 
-std::vector<Error*> Parser:: GetErrors() {
-	return errors;
+template <class TBuilder>
+auto BasicParser<TBuilder>::ParseFunction(int firstToken) -> Function {
+	tokenNum = firstToken - 1;
+	getNextToken();
+	return parseFunction();
+}
+
+template <class TBuilder>
+void BasicParser<TBuilder>::error(DiagnosticCode code)
+{
+	diagnostics.report(code, curToken.offset);
 }
 
-Parser::~Parser()
+// Panic mode: skips the rest of a broken statement, up to and including its ';',
+// or up to the '}' or keyword that starts whatever follows it
+template <class TBuilder>
+void BasicParser<TBuilder>::synchronize()
 {
-	for (auto item : errors) {
-		delete item;
+	while (!STATEMENT_SYNC.contains(curToken.type)) {
+		bool semicolon = curToken.type == TokenType::Semicolon;
+		getNextToken();
+		if (semicolon) { return; }
 	}
-	errors.clear();
 }
 
-void Parser::getNextToken()
+template <class TBuilder>
+void BasicParser<TBuilder>::getNextToken()
 {
-	curToken = tokens[++tokenNum];
+	curToken = tokens.get(++tokenNum);
 }
 
-void Parser::getPrevToken()
+template <class TBuilder>
+void BasicParser<TBuilder>::getPrevToken()
 {
-	curToken = tokens[--tokenNum];
+	curToken = tokens.get(--tokenNum);
 }
 
-std::unique_ptr<ProgramAST> Parser::parseProgram() {
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseProgram() -> Program {
 	getNextToken();
-	auto func = parseFunction();
-	if (!func) { return nullptr; }
-	if (curToken.type != TokenType::End) {
-		return nullptr;
+	std::vector<Function> functions;
+
+	// <program> := <function> { <function> }
+	do {
+		auto func = parseFunction();
+		if (func) {
+			functions.push_back(func);
+		}
+		else {
+			skipToNextFunction();
+		}
+	} while (PARSE_TABLE.predict(Nonterminal::FUNCTION_LIST, curToken.type) != Rule::FUNCTION_LIST_END);
+
+	if (functions.empty()) { return nullptr; }
+	return builder.program(functions.data(), functions.data() + functions.size());
+}
+
+// Skips a function whose header is broken, up to the next "int <id> (" or the end of input
+template <class TBuilder>
+void BasicParser<TBuilder>::skipToNextFunction()
+{
+	while (curToken.type != TokenType::End) {
+		getNextToken();
+		if (curToken.type == TokenType::IntType && tokens.get(tokenNum + 1).type == TokenType::Identifier
+			&& tokens.get(tokenNum + 2).type == TokenType::OpenParenthese) {
+			return;
+		}
 	}
-	return std::make_unique<ProgramAST>(std::move(func));
 }
 
-std::unique_ptr<FunctionAST> Parser::parseFunction() {
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseFunction() -> Function {
 	if (curToken.type != TokenType::IntType) { 
-		errors.push_back(CompilerError::errorAtLine("Expected 'int'!", curToken));
+		error(DiagnosticCode::EXPECTED_INT);
 		return nullptr; 
 	}
 
 	getNextToken();
 	if (curToken.type != TokenType::Identifier) { 
-		errors.push_back(CompilerError::errorAtLine("Function definition must have identifier.", curToken));
+		error(DiagnosticCode::EXPECTED_FUNCTION_NAME);
 		return nullptr; 
 	}
-	auto name = curToken.lexeme;
+	Symbol name = curToken.symbol;
+	uint32_t offset = curToken.offset;
 
 	getNextToken();
 	if (curToken.type != TokenType::OpenParenthese) { 
-		errors.push_back(CompilerError::errorAtLine("Expected '('!", curToken));
+		error(DiagnosticCode::EXPECTED_OPEN_PARENTHESE);
 		return nullptr; 
 	}
 
 	getNextToken();
 	if (curToken.type != TokenType::CloseParenthese) { 
-		errors.push_back(CompilerError::errorAtLine("Expected ')'!", curToken));
+		error(DiagnosticCode::EXPECTED_CLOSE_PARENTHESE);
 		return nullptr; 
 	}
 
@@ -66,110 +107,137 @@ std::unique_ptr<FunctionAST> Parser::parseFunction() {
 	auto block = parseBlock();
 	if (!block) { return nullptr; }
 
-	return std::make_unique<FunctionAST>(name, std::move(block));
+	return builder.function(name, offset, block);
 }
 
-std::unique_ptr<BlockAST> Parser::parseBlock()
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseBlock() -> Block
 {
 	if (curToken.type != TokenType::OpenBrace) {
-		errors.push_back(CompilerError::errorAtLine("Expected '{'!", curToken));
+		error(DiagnosticCode::EXPECTED_OPEN_BRACE);
 		return nullptr;
 	}
 
-	std::vector<std::unique_ptr<BlockItemAST>> items;
+	// Items of enclosing blocks stay below itemsBase until those blocks are finished
+	size_t itemsBase = pendingItems.size();
 	getNextToken();
-	while (true) {
-		if (BLOCK_ITEM_FIRST.find(curToken.type) == BLOCK_ITEM_FIRST.end()) {
-			break;
+	while (curToken.type != TokenType::CloseBrace && curToken.type != TokenType::End) {
+		if (PARSE_TABLE.predict(Nonterminal::BLOCK_ITEMS, curToken.type) != Rule::BLOCK_ITEMS_MORE) {
+			// A token that cannot start an item, such as a stray ')' or 'else'
+			error(DiagnosticCode::EXPECTED_CLOSE_BRACE);
+			getNextToken();
+			synchronize();
+			continue;
 		}
 
 		auto item = parseBlockItem();
-		if (item == nullptr) { return nullptr; };
-		items.push_back(std::move(item));
+		if (!item) {
+			synchronize();
+			continue;
+		}
+		pendingItems.push_back(item);
 	}
 
+	// A block cut short by the end of input keeps the items parsed so far
 	if (curToken.type != TokenType::CloseBrace) {
-		errors.push_back(CompilerError::errorAtLine("Expected '}'!", curToken));
-		return nullptr;
+		error(DiagnosticCode::EXPECTED_CLOSE_BRACE);
+	}
+	else {
+		getNextToken();
 	}
 
-	if (tokenNum + 1 < tokens.size()) { getNextToken(); }
-	return std::make_unique<BlockAST>(items);
+	auto block = builder.block(pendingItems.data() + itemsBase, pendingItems.data() + pendingItems.size());
+	pendingItems.resize(itemsBase);
+	return block;
 }
 
-std::unique_ptr<BlockItemAST> Parser::parseBlockItem() {
-	if (curToken.type == TokenType::IntType) {
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseBlockItem() -> BlockItem {
+	Rule rule = PARSE_TABLE.predict(Nonterminal::BLOCK_ITEM, curToken.type);
+	if (rule == Rule::BLOCK_ITEM_DECLARATION) {
 		auto declaration = parseDeclaration();
 		
 		if (!declaration) {
 			return nullptr;
 		}
-		return std::make_unique<BlockItemAST>(std::move(declaration));
+		return builder.declarationItem(declaration);
 	}
-	else if (STATEMENT_FIRST.find(curToken.type) != STATEMENT_FIRST.end()) {
+	else if (rule == Rule::BLOCK_ITEM_STATEMENT) {
 		auto statement = parseStatement();
 
 		if (!statement) {
 			return nullptr;
 		}
-		return std::make_unique<BlockItemAST>(std::move(statement));
+		return builder.statementItem(statement);
 	}
 
 	return nullptr;
 }
 
-std::unique_ptr<DeclarationAST> Parser::parseDeclaration()
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseDeclaration() -> Declaration
 {
 	getNextToken();
 	if (curToken.type != TokenType::Identifier) {
-		errors.push_back(CompilerError::errorAtLine("Expected identifier!", curToken));
+		error(DiagnosticCode::EXPECTED_IDENTIFIER);
 		return nullptr;
 	}
-	std::string name = curToken.lexeme;
+	Symbol name = curToken.symbol;
+	uint32_t offset = curToken.offset;
 
 	getNextToken();
+	Rule rule = PARSE_TABLE.predict(Nonterminal::DECLARATION_TAIL, curToken.type);
 	// <declaration> := "int" <id> ";"
-	if (curToken.type == TokenType::Semicolon) {
+	if (rule == Rule::DECLARATION_EMPTY) {
 		getNextToken();
 
-		return std::make_unique<DeclarationAST>(name);
+		return builder.declaration(name, offset, nullptr);
 	}
 
-	std::unique_ptr<ExprAST> expr;
+	// Once the name is known the variable stays declared even if the rest is broken,
+	// so that its uses do not report it as undeclared
+	Expr expr = nullptr;
 	// <declaration> := "int" <id> "=" <exp> ";"
-	if (curToken.type == TokenType::Assignment) {
+	if (rule == Rule::DECLARATION_INITIALIZED) {
 		getNextToken();
 
 		expr = parseExpression();
 		if (!expr) {
-			errors.push_back(CompilerError::errorAtLine("Invalid expression!", curToken));
-			return nullptr;
+			error(DiagnosticCode::INVALID_EXPRESSION);
+			synchronize();
+			return builder.declaration(name, offset, nullptr);
 		}
 	}
 
 	if (curToken.type != TokenType::Semicolon) {
-		errors.push_back(CompilerError::errorAtLine("Expected ';'!", curToken));
-		return nullptr;
+		error(DiagnosticCode::EXPECTED_SEMICOLON);
+		synchronize();
+		return builder.declaration(name, offset, expr);
 	}
 	getNextToken();
 
-	return std::make_unique<DeclarationAST>(name, std::move(expr));
+	return builder.declaration(name, offset, expr);
 }
 
-std::unique_ptr<ConditionAST> Parser::parseCondition()
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseCondition() -> Condition
 {
 	getNextToken();
 
 	if (curToken.type != TokenType::OpenParenthese) {
-		errors.push_back(CompilerError::errorAtLine("Expected '('!", curToken));
+		error(DiagnosticCode::EXPECTED_OPEN_PARENTHESE);
 		return nullptr;
 	}
 
 	getNextToken();
 	auto expr = parseExpression();
+	if (!expr) {
+		error(DiagnosticCode::INVALID_EXPRESSION);
+		return nullptr;
+	}
 
 	if (curToken.type != TokenType::CloseParenthese) {
-		errors.push_back(CompilerError::errorAtLine("Expected ')'!", curToken));
+		error(DiagnosticCode::EXPECTED_CLOSE_PARENTHESE);
 		return nullptr;
 	}
 
@@ -177,78 +245,215 @@ std::unique_ptr<ConditionAST> Parser::parseCondition()
 	auto ifClause = parseBlock();
 	if (!ifClause) { return nullptr; }
 	
-	if (curToken.type == TokenType::ElseOperator) {
+	if (PARSE_TABLE.predict(Nonterminal::ELSE_CLAUSE, curToken.type) == Rule::ELSE_CLAUSE) {
 		getNextToken();
 		auto elseClause = parseBlock();
 		if (!elseClause) { return nullptr; }
 
-		return std::make_unique<ConditionAST>(std::move(expr), std::move(ifClause), std::move(elseClause));
+		return builder.condition(expr, ifClause, elseClause);
 	}
 
-	return std::make_unique<ConditionAST>(std::move(expr), std::move(ifClause), nullptr);
+	return builder.condition(expr, ifClause, nullptr);
 }
 
-std::unique_ptr<StatementAST> Parser::parseStatement() {
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseStatement() -> Statement {
+	Rule rule = PARSE_TABLE.predict(Nonterminal::STATEMENT, curToken.type);
 	// <statement> := "return" <expr> ";"
-	if (curToken.type == TokenType::ReturnKeyword)
+	if (rule == Rule::STATEMENT_RETURN)
 	{
 		getNextToken();
 		auto expr = parseExpression();
 		if (!expr) {
-			errors.push_back(CompilerError::errorAtLine("Function must return a value!", curToken));
+			error(DiagnosticCode::MISSING_RETURN_VALUE);
 			return nullptr;
 		}
 
 		if (curToken.type != TokenType::Semicolon) {
-			errors.push_back(CompilerError::errorAtLine("Expected ';'!", curToken));
+			error(DiagnosticCode::EXPECTED_SEMICOLON);
 			return nullptr;
 		}
 
 		getNextToken();
-		return std::make_unique<StatementAST>(StatementType::RETURN_STATEMENT, std::move(expr));
+		return builder.statement(StatementType::RETURN_STATEMENT, expr);
 	}
 	// <statement> := <expr> ";"
-	else if (EXPRESSION_FIRST.find(curToken.type) != EXPRESSION_FIRST.end()) {
+	else if (rule == Rule::STATEMENT_EXPRESSION) {
 		auto expr = parseExpression();
 		if (!expr) {
-			errors.push_back(CompilerError::errorAtLine("Invalid expression!", curToken));
+			error(DiagnosticCode::INVALID_EXPRESSION);
 			return nullptr;
 		}
 
 		if (curToken.type != TokenType::Semicolon) {
-			errors.push_back(CompilerError::errorAtLine("Expected ';'!", curToken));
+			error(DiagnosticCode::EXPECTED_SEMICOLON);
 			return nullptr;
 		}
 
 		getNextToken();
-		return std::make_unique<StatementAST>(StatementType::EXPRESSION_STATEMENT, std::move(expr));
+		return builder.statement(StatementType::EXPRESSION_STATEMENT, expr);
 	}
-	else if (curToken.type == TokenType::OpenBrace) {
+	else if (rule == Rule::STATEMENT_BLOCK) {
 		auto block = parseBlock();
 
 		if (!block) {
 			return nullptr;
 		}
 
-		return std::make_unique<StatementAST>(std::move(block));
+		return builder.blockStatement(block);
 	}
 	// <statement> := if(<expr>) <block> [ else <block> ]
-	else if (curToken.type == TokenType::IfOperator) {
+	else if (rule == Rule::STATEMENT_CONDITION) {
 		auto condition = parseCondition();
 		if (!condition) {
 			return nullptr;
 		}
-		return std::make_unique<StatementAST>(std::move(condition));
+		return builder.conditionStatement(condition);
 	}
 
 	return nullptr;
 }
 
-std::unique_ptr<ExprAST> Parser::parseExpression()
+// Binding power of a binary operator, 0 for tokens that are not binary operators
+static int binaryPrecedence(TokenType type) {
+	switch (type) {
+	case TokenType::LogicalOr: return 1;
+	case TokenType::LogicalAnd: return 2;
+	case TokenType::Equal: case TokenType::NotEqual: return 3;
+	case TokenType::Less: case TokenType::Greater: return 4;
+	case TokenType::Addition: case TokenType::Negation: return 5;
+	case TokenType::Multiplication: case TokenType::Division: return 6;
+	default: return 0;
+	}
+}
+
+static const int ASSIGNMENT_PRECEDENCE = 0;
+static const int UNARY_PRECEDENCE = 7;
+
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseExpression() -> Expr
+{
+	if (expressionParsing == ExpressionParsing::RECURSIVE_DESCENT) {
+		return parseAssignmentExpression();
+	}
+
+	// Precedence climbing over explicit stacks: operators wait on the stack until an
+	// operator that binds weaker, a ')' or the end of the expression completes them.
+	// Nesting depth is bounded only by memory, not by the native stack.
+	operators.clear();
+	operands.clear();
+	bool expressionStart = true;
+
+	while (true) {
+		// <expr> := <id> "=" <expr>, only where a whole expression may begin
+		if (expressionStart && curToken.type == TokenType::Identifier && tokens.get(tokenNum + 1).type == TokenType::Assignment) {
+			operators.push_back({ PendingKind::ASSIGNMENT, TokenType::Assignment, ASSIGNMENT_PRECEDENCE, curToken.symbol, curToken.offset });
+			getNextToken();
+			getNextToken();
+			continue;
+		}
+
+		if (curToken.type == TokenType::OpenParenthese) {
+			operators.push_back({ PendingKind::PARENTHESE, TokenType::OpenParenthese, ASSIGNMENT_PRECEDENCE, 0, 0 });
+			getNextToken();
+			expressionStart = true;
+			continue;
+		}
+
+		if (curToken.isUnaryOperator()) {
+			operators.push_back({ PendingKind::UNARY, curToken.type, UNARY_PRECEDENCE, 0, 0 });
+			getNextToken();
+			expressionStart = false;
+			continue;
+		}
+
+		if (curToken.type == TokenType::IntValue) {
+			if (curToken.outOfRange) { error(DiagnosticCode::CONSTANT_OUT_OF_RANGE); }
+			operands.push_back(builder.intLiteral(curToken.intVal));
+		}
+		else if (curToken.type == TokenType::Identifier) {
+			operands.push_back(builder.variable(curToken.symbol, curToken.offset));
+		}
+		else {
+			return abandonExpression();
+		}
+		getNextToken();
+
+		// The operand is complete: close parentheses until a binary operator continues the expression
+		while (true) {
+			reduceOperators(UNARY_PRECEDENCE);
+
+			int precedence = binaryPrecedence(curToken.type);
+			if (precedence) {
+				reduceOperators(precedence);
+				operators.push_back({ PendingKind::BINARY, curToken.type, precedence, 0, 0 });
+				getNextToken();
+				expressionStart = false;
+				break;
+			}
+
+			reduceOperators(ASSIGNMENT_PRECEDENCE);
+			if (operators.empty()) {
+				return operands.back();
+			}
+
+			if (curToken.type != TokenType::CloseParenthese) {
+				error(DiagnosticCode::EXPECTED_CLOSE_PARENTHESE);
+				operators.pop_back();
+				return abandonExpression();
+			}
+			operators.pop_back();
+			getNextToken();
+		}
+	}
+}
+
+template <class TBuilder>
+void BasicParser<TBuilder>::reduceOperators(int precedence)
+{
+	while (!operators.empty() && operators.back().kind != PendingKind::PARENTHESE && operators.back().precedence >= precedence) {
+		PendingOperator pending = operators.back();
+		operators.pop_back();
+
+		Expr operand = operands.back();
+		operands.pop_back();
+		if (pending.kind == PendingKind::BINARY) {
+			operands.back() = builder.binary(operands.back(), pending.op, operand);
+		}
+		else if (pending.kind == PendingKind::UNARY) {
+			operands.push_back(builder.unary(pending.op, operand));
+		}
+		else {
+			operands.push_back(builder.assignment(pending.name, pending.offset, operand));
+		}
+	}
+}
+
+// Reports a missing operand to every pending operator, innermost first, as the recursive chain does
+template <class TBuilder>
+auto BasicParser<TBuilder>::abandonExpression() -> Expr
+{
+	for (auto it = operators.rbegin(); it != operators.rend(); ++it) {
+		if (it->kind == PendingKind::BINARY) {
+			error(DiagnosticCode::WRONG_RIGHT_OPERAND);
+		}
+		else if (it->kind == PendingKind::UNARY) {
+			error(DiagnosticCode::WRONG_OPERAND);
+		}
+		else if (it->kind == PendingKind::ASSIGNMENT) {
+			error(DiagnosticCode::INVALID_EXPRESSION);
+		}
+	}
+	return nullptr;
+}
+
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseAssignmentExpression() -> Expr
 {
 	// <expr> := <id> "=" <expr>
 	if (curToken.type == TokenType::Identifier) {
-		auto name = curToken.lexeme;
+		Symbol name = curToken.symbol;
+		uint32_t offset = curToken.offset;
 
 		getNextToken();
 		if (curToken.type != TokenType::Assignment) {
@@ -259,11 +464,11 @@ std::unique_ptr<ExprAST> Parser::parseExpression()
 		getNextToken();
 		auto expr = parseExpression();
 		if (!expr) {
-			errors.push_back(CompilerError::errorAtLine("Invalid expression!", curToken));
+			error(DiagnosticCode::INVALID_EXPRESSION);
 			return nullptr;
 		}
 
-		return std::make_unique<ExprAST>(name, std::move(expr));
+		return builder.assignment(name, offset, expr);
 	}
 	// <expr> := <logical-expr> 
 	else {
@@ -271,94 +476,115 @@ std::unique_ptr<ExprAST> Parser::parseExpression()
 	}
 }
 
-std::unique_ptr<ExprAST> Parser::parseLogicalOrExpression() {
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseLogicalOrExpression() -> Expr {
 	auto left = parseLogicalAndExpression();
+	if (!left) {
+		return nullptr;
+	}
 
 	while (curToken.type == TokenType::LogicalOr) {
 		auto opType = curToken.type;
 		getNextToken();
 		auto right = parseLogicalAndExpression();
 		if (!right) {
-			errors.push_back(CompilerError::errorAtLine("Wrong right operand!", curToken));
+			error(DiagnosticCode::WRONG_RIGHT_OPERAND);
 			return nullptr;
 		}
-		left = std::make_unique<ExprAST>(std::move(left), opType, std::move(right));
+		left = builder.binary(left, opType, right);
 	}
 
-	return std::move(left);
+	return left;
 }
 
-std::unique_ptr<ExprAST> Parser::parseLogicalAndExpression() {
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseLogicalAndExpression() -> Expr {
 	auto left = parseEqualityExpression();
+	if (!left) {
+		return nullptr;
+	}
 
 	while (curToken.type == TokenType::LogicalAnd) {
 		auto opType = curToken.type;
 		getNextToken();
 		auto right = parseEqualityExpression();
 		if (!right) {
-			errors.push_back(CompilerError::errorAtLine("Wrong right operand!", curToken));
+			error(DiagnosticCode::WRONG_RIGHT_OPERAND);
 			return nullptr;
 		}
-		left = std::make_unique<ExprAST>(std::move(left), opType, std::move(right));
+		left = builder.binary(left, opType, right);
 	}
 
-	return std::move(left);
+	return left;
 }
 
-std::unique_ptr<ExprAST> Parser::parseEqualityExpression()
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseEqualityExpression() -> Expr
 {
 	auto left = parseComparasionExpression();
+	if (!left) {
+		return nullptr;
+	}
 
 	while (curToken.type == TokenType::Equal || curToken.type == TokenType::NotEqual) {
 		auto opType = curToken.type;
 		getNextToken();
 		auto right = parseComparasionExpression();
 		if (!right) {
-			errors.push_back(CompilerError::errorAtLine("Wrong right operand!", curToken));
+			error(DiagnosticCode::WRONG_RIGHT_OPERAND);
 			return nullptr;
 		}
-		left = std::make_unique<ExprAST>(std::move(left), opType, std::move(right));
+		left = builder.binary(left, opType, right);
 	}
 
-	return std::move(left);
+	return left;
 }
 
-std::unique_ptr<ExprAST> Parser::parseComparasionExpression()
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseComparasionExpression() -> Expr
 {
 	auto left = parseAdditiveExpression();
+	if (!left) {
+		return nullptr;
+	}
 
 	while (curToken.type == TokenType::Less || curToken.type == TokenType::Greater) {
 		auto opType = curToken.type;
 		getNextToken();
 		auto right = parseAdditiveExpression();
 		if (!right) {
-			errors.push_back(CompilerError::errorAtLine("Wrong right operand!", curToken));
+			error(DiagnosticCode::WRONG_RIGHT_OPERAND);
 			return nullptr;
 		}
-		left = std::make_unique<ExprAST>(std::move(left), opType, std::move(right));
+		left = builder.binary(left, opType, right);
 	}
 
-	return std::move(left);
+	return left;
 }
 
-std::unique_ptr<ExprAST> Parser::parseAdditiveExpression() {
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseAdditiveExpression() -> Expr {
 	auto left = parseTerm();
+	if (!left) {
+		return nullptr;
+	}
 
 	while (curToken.type == TokenType::Addition || curToken.type == TokenType::Negation) {
 		auto opType = curToken.type;
 		getNextToken();
 		auto right = parseTerm();
 		if (!right) {
-			errors.push_back(CompilerError::errorAtLine("Wrong right operand!", curToken));
+			error(DiagnosticCode::WRONG_RIGHT_OPERAND);
 			return nullptr;
 		}
-		left = std::make_unique<ExprAST>(std::move(left), opType, std::move(right));
+		left = builder.binary(left, opType, right);
 	}
 
-	return std::move(left);
+	return left;
 }
 
-std::unique_ptr<ExprAST> Parser::parseFactor()
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseFactor() -> Expr
 {
 	if (curToken.type == TokenType::OpenParenthese) {
 		getNextToken();
@@ -368,52 +594,64 @@ std::unique_ptr<ExprAST> Parser::parseFactor()
 		}
 
 		if (curToken.type != TokenType::CloseParenthese) {
-			errors.push_back(CompilerError::errorAtLine("Expected ')'!", curToken));
+			error(DiagnosticCode::EXPECTED_CLOSE_PARENTHESE);
 			return nullptr;
 		}
 		getNextToken();
 
-		return std::move(expr);
+		return expr;
 	}
 	else if (curToken.isUnaryOperator()) {
 		auto unOp = curToken;
 		getNextToken();
 		auto factor = parseFactor();
 		if (!factor) {
-			errors.push_back(CompilerError::errorAtLine("Wrong operand!", curToken));
+			error(DiagnosticCode::WRONG_OPERAND);
 			return nullptr;
 		}
-		getNextToken();
 
-		return std::make_unique<ExprAST>(unOp.type, std::move(factor));
+		return builder.unary(unOp.type, factor);
 
 	}
 	else if (curToken.type == TokenType::IntValue) {
 		int value = curToken.intVal;
+		if (curToken.outOfRange) { error(DiagnosticCode::CONSTANT_OUT_OF_RANGE); }
 		getNextToken();
 
-		return std::make_unique<ExprAST>(value);
+		return builder.intLiteral(value);
 	}
 	else if (curToken.type == TokenType::Identifier) {
-		std::string lexeme = curToken.lexeme;
+		Symbol name = curToken.symbol;
+		uint32_t offset = curToken.offset;
 		getNextToken();
 
-		return std::make_unique<ExprAST>(lexeme);
+		return builder.variable(name, offset);
 	}
 
 	return nullptr;
 }
 
-std::unique_ptr<ExprAST> Parser::parseTerm()
+template <class TBuilder>
+auto BasicParser<TBuilder>::parseTerm() -> Expr
 {
 	auto left = parseFactor();
+	if (!left) {
+		return nullptr;
+	}
 
 	while (curToken.type == TokenType::Multiplication || curToken.type == TokenType::Division) {
 		auto opType = curToken.type;
 		getNextToken();
 		auto right = parseFactor();
-		left = std::make_unique<ExprAST>(std::move(left), opType, std::move(right));
+		if (!right) {
+			error(DiagnosticCode::WRONG_RIGHT_OPERAND);
+			return nullptr;
+		}
+		left = builder.binary(left, opType, right);
 	}
 
-	return std::move(left);
+	return left;
 }
+
+template class BasicParser<ArenaAstBuilder>;
+template class BasicParser<FlatAstBuilder>;
\ No newline at end of file
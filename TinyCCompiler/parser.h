@@ -2,45 +2,88 @@
 #define PARSER_H
 
 #include "ast.h"
+#include "flat_ast.h"
 #include "token.h"
-#include "error.h"
-#include "algorithm.h"
+#include "token_stream.h"
+#include "diagnostics.h"
+#include "grammar.h"
 
 #include <vector>
-#include <set>
 
-const std::set<TokenType> EXPRESSION_FIRST = { Identifier, OpenParenthese, IntValue, Negation, BitwiseComplement, LogicalNegation };
-const std::set<TokenType> STATEMENT_FIRST = setUnion(EXPRESSION_FIRST, { OpenBrace, ReturnKeyword, IfOperator });
-const std::set<TokenType> BLOCK_ITEM_FIRST = setUnion(STATEMENT_FIRST, { IntType });
+enum class ExpressionParsing {
+	PRECEDENCE_CLIMBING,
+	RECURSIVE_DESCENT // One function per precedence level, kept for comparison
+};
 
-class Parser {
+// Recursive descent parser. Nodes are created through TBuilder, which decides
+// the tree representation: ArenaAstBuilder or FlatAstBuilder.
+template <class TBuilder>
+class BasicParser {
 public:
-	Parser(const std::vector<Token>& _tokens) : tokens(_tokens), tokenNum(-1) {};
-	std::unique_ptr<ProgramAST> Parse();
-	std::vector<Error*> GetErrors();
-	~Parser();
+	typedef typename TBuilder::Program Program;
+	typedef typename TBuilder::Function Function;
+	typedef typename TBuilder::Block Block;
+	typedef typename TBuilder::BlockItem BlockItem;
+	typedef typename TBuilder::Declaration Declaration;
+	typedef typename TBuilder::Condition Condition;
+	typedef typename TBuilder::Statement Statement;
+	typedef typename TBuilder::Expr Expr;
+
+	BasicParser(TokenSource& _tokens, TBuilder _builder, ExpressionParsing _expressionParsing = ExpressionParsing::PRECEDENCE_CLIMBING)
+		: tokenNum(-1), tokens(_tokens), builder(_builder), expressionParsing(_expressionParsing) {};
+	Program Parse();
+	// Parses only the function that starts at token firstToken, e.g. one that changed since the
+	// last build. NextToken() is then the token right after it.
+	Function ParseFunction(int firstToken);
+	int NextToken() const { return tokenNum; }
+	// Every syntax error found; the parser recovers at statement boundaries and goes on
+	const Diagnostics& GetDiagnostics() const { return diagnostics; }
 private:
 	int tokenNum;
-	Token curToken;
-	std::vector<Token> tokens;
+	CompactToken curToken;
+	TokenSource& tokens;
+	TBuilder builder;
+	std::vector<BlockItem> pendingItems; // Items of the blocks being parsed
+
+	enum class PendingKind : uint8_t { BINARY, UNARY, ASSIGNMENT, PARENTHESE };
+	struct PendingOperator {
+		PendingKind kind;
+		TokenType op;
+		int precedence;
+		Symbol name; // Assigned variable
+		uint32_t offset;
+	};
+
+	ExpressionParsing expressionParsing;
+	std::vector<PendingOperator> operators;
+	std::vector<Expr> operands;
 	void getNextToken();
+	void error(DiagnosticCode code);
+	void synchronize();
+	void skipToNextFunction();
 	void getPrevToken();
-	std::unique_ptr<ProgramAST> parseProgram();
-	std::unique_ptr<FunctionAST> parseFunction();
-	std::unique_ptr<BlockAST> parseBlock();
-	std::unique_ptr<BlockItemAST> parseBlockItem();
-	std::unique_ptr<DeclarationAST> parseDeclaration();
-	std::unique_ptr<ConditionAST> parseCondition();
-	std::unique_ptr<StatementAST> parseStatement();
-	std::unique_ptr<ExprAST> parseExpression();
-	std::unique_ptr<ExprAST> parseLogicalOrExpression();
-	std::unique_ptr<ExprAST> parseLogicalAndExpression();
-	std::unique_ptr<ExprAST> parseEqualityExpression();
-	std::unique_ptr<ExprAST> parseComparasionExpression();
-	std::unique_ptr<ExprAST> parseAdditiveExpression();
-	std::unique_ptr<ExprAST> parseFactor();
-	std::unique_ptr<ExprAST> parseTerm();
-	std::vector<Error*> errors;
+	Program parseProgram();
+	Function parseFunction();
+	Block parseBlock();
+	BlockItem parseBlockItem();
+	Declaration parseDeclaration();
+	Condition parseCondition();
+	Statement parseStatement();
+	Expr parseExpression();
+	void reduceOperators(int precedence);
+	Expr abandonExpression();
+	Expr parseAssignmentExpression();
+	Expr parseLogicalOrExpression();
+	Expr parseLogicalAndExpression();
+	Expr parseEqualityExpression();
+	Expr parseComparasionExpression();
+	Expr parseAdditiveExpression();
+	Expr parseFactor();
+	Expr parseTerm();
+	Diagnostics diagnostics;
 };
 
+typedef BasicParser<ArenaAstBuilder> Parser;
+typedef BasicParser<FlatAstBuilder> FlatParser;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "program_generator.h"
+
+#include <random>
+#include <vector>
+
+class ProgramGenerator {
+public:
+	ProgramGenerator(const GeneratorOptions& _options) : options(_options), random(_options.seed), variableCount(0) {};
+
+	std::string generate() {
+		code.reserve(options.targetBytes + 1024);
+		int functions = options.functions > 1 ? options.functions : 1;
+		for (int i = 1; i < functions; i++) {
+			function("f" + std::to_string(i - 1), options.targetBytes * i / functions);
+		}
+		function("main", options.targetBytes);
+		return code;
+	}
+
+private:
+	const GeneratorOptions& options;
+	std::mt19937 random;
+	std::string code;
+	std::vector<std::vector<std::string>> scopes;
+	int variableCount;
+
+	int chance(int outOf) { return int(random() % uint32_t(outOf)); }
+	void indent(int level) { code.append(size_t(level), '\t'); }
+
+	bool hasVariables() {
+		for (auto& scope : scopes) {
+			if (!scope.empty()) { return true; }
+		}
+		return false;
+	}
+
+	const std::string& anyVariable() {
+		while (true) {
+			auto& scope = scopes[random() % scopes.size()];
+			if (!scope.empty()) { return scope[random() % scope.size()]; }
+		}
+	}
+
+	std::string newVariableName() {
+		std::string name = "v" + std::to_string(variableCount++);
+		while (name.size() < size_t(options.identifierLength)) { name.insert(1, 1, char('a' + chance(26))); }
+		return name;
+	}
+
+	// Appends a function whose body grows the program to about endBytes
+	void function(const std::string& name, size_t endBytes) {
+		code += "int " + name + "() {\n";
+		scopes.clear();
+		scopes.emplace_back();
+		while (code.size() < endBytes) { blockItem(1); }
+		code += "\treturn ";
+		expression(options.expressionDepth);
+		code += ";\n}\n";
+	}
+
+	void blockItem(int level) {
+		int kind = hasVariables() ? chance(100) : 0;
+		if (kind < 40) {
+			std::string name = newVariableName();
+			indent(level);
+			code += "int " + name;
+			if (chance(4) != 0) {
+				code += " = ";
+				expression(options.expressionDepth);
+			}
+			code += ";\n";
+			scopes.back().push_back(name);
+		}
+		else if (kind < 75 || level > options.nesting) {
+			indent(level);
+			code += anyVariable() + " = ";
+			expression(options.expressionDepth);
+			code += ";\n";
+		}
+		else if (kind < 90) {
+			indent(level);
+			code += "if (";
+			expression(options.expressionDepth);
+			code += ") ";
+			block(level);
+			if (chance(2)) {
+				code += " else ";
+				block(level);
+			}
+			code += "\n";
+		}
+		else {
+			indent(level);
+			block(level);
+			code += "\n";
+		}
+	}
+
+	void block(int level) {
+		code += "{\n";
+		scopes.emplace_back();
+		int items = 1 + chance(5);
+		for (int i = 0; i < items; i++) { blockItem(level + 1); }
+		scopes.pop_back();
+		indent(level);
+		code += "}";
+	}
+
+	void expression(int depth) {
+		// Unary chains, such as --x or ~!(a < b), on a leaf or a parenthesized operand
+		if (chance(6) == 0) {
+			static const char unaryOperators[] = { '-', '~', '!' };
+			int count = 1 + chance(3);
+			for (int i = 0; i < count; i++) { code += unaryOperators[chance(3)]; }
+			if (depth > 0 && chance(2)) {
+				code += "(";
+				expression(depth - 1);
+				code += ")";
+			}
+			else {
+				expression(0);
+			}
+			return;
+		}
+
+		if (depth == 0 || chance(10) < 3) {
+			if (hasVariables() && chance(2)) { code += anyVariable(); }
+			else if (chance(8) == 0) { code += "0b" + std::to_string(chance(2)) + "1" + std::to_string(chance(2)); }
+			else { code += std::to_string(chance(100000)); }
+			return;
+		}
+
+		static const char* operators[] = { " + ", " - ", " * ", " / ", " < ", " > ", " == ", " && ", " || " };
+		bool parentheses = chance(3) == 0;
+		if (parentheses) { code += "("; }
+		expression(depth - 1);
+		code += operators[chance(9)];
+		expression(depth - 1);
+		if (parentheses) { code += ")"; }
+	}
+};
+
+std::string generateProgram(const GeneratorOptions& options) {
+	return ProgramGenerator(options).generate();
+}
\ No newline at end of file
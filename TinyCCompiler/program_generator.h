@@ -0,0 +1,20 @@
+#ifndef PROGRAM_GENERATOR_H
+#define PROGRAM_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+
+struct GeneratorOptions {
+	size_t targetBytes = 1 << 20;
+	int expressionDepth = 4;    // Maximum depth of operator trees
+	int nesting = 3;            // Maximum depth of nested if/else and blocks
+	int identifierLength = 8;   // Length of generated variable names
+	int functions = 1;          // Functions sharing targetBytes; main comes last
+	uint32_t seed = 1;
+};
+
+// Generates a random TinyC program that the parser accepts and the code
+// generator compiles. The same options always produce the same program.
+std::string generateProgram(const GeneratorOptions& options);
+
+#endif
\ No newline at end of file
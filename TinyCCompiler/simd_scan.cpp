@@ -0,0 +1,210 @@
+#include "simd_scan.h"
+
+#include <cstdint>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SIMD_SCAN_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+static bool isWhitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+static bool isIdentifierChar(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || isDigit(c); }
+
+static const char* skipWhitespaceScalar(const char* begin, const char* end) {
+	while (begin != end && isWhitespace(*begin)) { ++begin; }
+	return begin;
+}
+
+static const char* skipIdentifierScalar(const char* begin, const char* end) {
+	while (begin != end && isIdentifierChar(*begin)) { ++begin; }
+	return begin;
+}
+
+static const char* skipDigitsScalar(const char* begin, const char* end) {
+	while (begin != end && isDigit(*begin)) { ++begin; }
+	return begin;
+}
+
+static size_t countNewlinesScalar(const char* begin, const char* end) {
+	size_t count = 0;
+	for (; begin != end; ++begin) { count += *begin == '\n'; }
+	return count;
+}
+
+#ifdef SIMD_SCAN_X86
+
+static unsigned lowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+// Per-byte "lo <= c <= hi" using signed compares: shift the range so that it starts at -128
+static __m128i inRangeSse2(__m128i v, char lo, char hi) {
+	__m128i shifted = _mm_add_epi8(v, _mm_set1_epi8(char(-128 - lo)));
+	return _mm_cmplt_epi8(shifted, _mm_set1_epi8(char(-128 + (hi - lo + 1))));
+}
+
+static __m128i whitespaceSse2(__m128i v) {
+	__m128i space = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+	__m128i control = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+	return _mm_or_si128(space, control);
+}
+
+static __m128i identifierSse2(__m128i v) {
+	__m128i letter = inRangeSse2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+	__m128i digit = inRangeSse2(v, '0', '9');
+	__m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+	return _mm_or_si128(_mm_or_si128(letter, digit), underscore);
+}
+
+template <__m128i (*Matches)(__m128i), const char* (*Tail)(const char*, const char*)>
+static const char* skipSse2(const char* begin, const char* end) {
+	while (end - begin >= 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+		uint32_t mismatch = ~uint32_t(_mm_movemask_epi8(Matches(v))) & 0xFFFF;
+		if (mismatch) { return begin + lowestBit(mismatch); }
+		begin += 16;
+	}
+	return Tail(begin, end);
+}
+
+static __m128i digitSse2(__m128i v) { return inRangeSse2(v, '0', '9'); }
+
+static size_t countNewlinesSse2(const char* begin, const char* end) {
+	const __m128i newline = _mm_set1_epi8('\n');
+	size_t count = 0;
+	while (end - begin >= 16) {
+		// Byte counters may take at most 255 increments before being summed up
+		__m128i counters = _mm_setzero_si128();
+		for (int i = 0; i < 255 && end - begin >= 16; i++, begin += 16) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+			counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(v, newline));
+		}
+		__m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+		count += size_t(_mm_cvtsi128_si32(sums)) + size_t(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+	}
+	return count + countNewlinesScalar(begin, end);
+}
+
+TARGET_AVX2 static __m256i inRangeAvx2(__m256i v, char lo, char hi) {
+	__m256i shifted = _mm256_add_epi8(v, _mm256_set1_epi8(char(-128 - lo)));
+	return _mm256_cmpgt_epi8(_mm256_set1_epi8(char(-128 + (hi - lo + 1))), shifted);
+}
+
+TARGET_AVX2 static __m256i whitespaceAvx2(__m256i v) {
+	__m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+	__m256i control = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+	return _mm256_or_si256(space, control);
+}
+
+TARGET_AVX2 static __m256i identifierAvx2(__m256i v) {
+	__m256i letter = inRangeAvx2(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+	__m256i digit = inRangeAvx2(v, '0', '9');
+	__m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+	return _mm256_or_si256(_mm256_or_si256(letter, digit), underscore);
+}
+
+TARGET_AVX2 static __m256i digitAvx2(__m256i v) { return inRangeAvx2(v, '0', '9'); }
+
+TARGET_AVX2 static const char* skipWhitespaceAvx2(const char* begin, const char* end) {
+	while (end - begin >= 32) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+		uint32_t mismatch = ~uint32_t(_mm256_movemask_epi8(whitespaceAvx2(v)));
+		if (mismatch) { return begin + lowestBit(mismatch); }
+		begin += 32;
+	}
+	return skipSse2<whitespaceSse2, skipWhitespaceScalar>(begin, end);
+}
+
+TARGET_AVX2 static const char* skipIdentifierAvx2(const char* begin, const char* end) {
+	while (end - begin >= 32) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+		uint32_t mismatch = ~uint32_t(_mm256_movemask_epi8(identifierAvx2(v)));
+		if (mismatch) { return begin + lowestBit(mismatch); }
+		begin += 32;
+	}
+	return skipSse2<identifierSse2, skipIdentifierScalar>(begin, end);
+}
+
+TARGET_AVX2 static const char* skipDigitsAvx2(const char* begin, const char* end) {
+	while (end - begin >= 32) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+		uint32_t mismatch = ~uint32_t(_mm256_movemask_epi8(digitAvx2(v)));
+		if (mismatch) { return begin + lowestBit(mismatch); }
+		begin += 32;
+	}
+	return skipSse2<digitSse2, skipDigitsScalar>(begin, end);
+}
+
+TARGET_AVX2 static size_t countNewlinesAvx2(const char* begin, const char* end) {
+	const __m256i newline = _mm256_set1_epi8('\n');
+	size_t count = 0;
+	while (end - begin >= 32) {
+		__m256i counters = _mm256_setzero_si256();
+		for (int i = 0; i < 255 && end - begin >= 32; i++, begin += 32) {
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+			counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(v, newline));
+		}
+		uint64_t sums[4];
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), _mm256_sad_epu8(counters, _mm256_setzero_si256()));
+		count += size_t(sums[0] + sums[1] + sums[2] + sums[3]);
+	}
+	return count + countNewlinesSse2(begin, end);
+}
+
+static bool cpuSupportsAvx2() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) { return false; }
+
+	// AVX2 also needs the OS to save YMM registers
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) { return false; }
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+static ScanKernels selectKernels() {
+#ifdef SIMD_SCAN_X86
+	if (cpuSupportsAvx2()) {
+		return { skipWhitespaceAvx2, skipIdentifierAvx2, skipDigitsAvx2, countNewlinesAvx2, "avx2" };
+	}
+	return {
+		skipSse2<whitespaceSse2, skipWhitespaceScalar>,
+		skipSse2<identifierSse2, skipIdentifierScalar>,
+		skipSse2<digitSse2, skipDigitsScalar>,
+		countNewlinesSse2,
+		"sse2"
+	};
+#else
+	return { skipWhitespaceScalar, skipIdentifierScalar, skipDigitsScalar, countNewlinesScalar, "scalar" };
+#endif
+}
+
+const ScanKernels& scanKernels() {
+	static const ScanKernels kernels = selectKernels();
+	return kernels;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <cstddef>
+
+// Character run scanners used by the lexers. Each function returns a pointer to
+// the first character in [begin, end) that does not belong to the run, or end.
+// The implementation (AVX2, SSE2 or scalar) is picked once at runtime.
+struct ScanKernels {
+	const char* (*skipWhitespace)(const char* begin, const char* end);
+	const char* (*skipIdentifier)(const char* begin, const char* end);
+	const char* (*skipDigits)(const char* begin, const char* end);
+	size_t (*countNewlines)(const char* begin, const char* end);
+	const char* name;
+};
+
+const ScanKernels& scanKernels();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "source_file.h"
+
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceFile::~SourceFile() {
+	unmap();
+}
+
+bool SourceFile::open(const std::string& filename) {
+	unmap();
+	if (map(filename)) { return true; }
+
+	std::ifstream input(filename, std::ifstream::binary);
+	if (!input.is_open()) { return false; }
+
+	buffer.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+	data = buffer.data();
+	size = buffer.size();
+	return true;
+}
+
+#ifdef _WIN32
+
+bool SourceFile::map(const std::string& filename) {
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) { return false; }
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 || uint64_t(fileSize.QuadPart) > SIZE_MAX) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping) { return false; }
+
+	// The view keeps the mapping alive after its handle is closed
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view) { return false; }
+
+	data = static_cast<const char*>(view);
+	size = size_t(fileSize.QuadPart);
+	mapped = true;
+	return true;
+}
+
+void SourceFile::unmap() {
+	if (mapped) { UnmapViewOfFile(data); }
+	data = nullptr;
+	size = 0;
+	mapped = false;
+	buffer.clear();
+}
+
+#else
+
+bool SourceFile::map(const std::string& filename) {
+	int file = ::open(filename.c_str(), O_RDONLY);
+	if (file < 0) { return false; }
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (view == MAP_FAILED) { return false; }
+	madvise(view, size_t(info.st_size), MADV_SEQUENTIAL);
+
+	data = static_cast<const char*>(view);
+	size = size_t(info.st_size);
+	mapped = true;
+	return true;
+}
+
+void SourceFile::unmap() {
+	if (mapped) { munmap(const_cast<char*>(data), size); }
+	data = nullptr;
+	size = 0;
+	mapped = false;
+	buffer.clear();
+}
+
+#endif
\ No newline at end of file
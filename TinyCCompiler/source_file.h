@@ -0,0 +1,28 @@
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+#include <string>
+#include <string_view>
+
+// Read-only view of an input file. The file is memory-mapped when possible and
+// read into memory otherwise (e.g. for empty files).
+class SourceFile {
+public:
+	SourceFile() : data(nullptr), size(0), mapped(false) {};
+	~SourceFile();
+	SourceFile(const SourceFile&) = delete;
+	SourceFile& operator=(const SourceFile&) = delete;
+
+	bool open(const std::string& filename);
+	std::string_view contents() const { return std::string_view(data, size); }
+private:
+	const char* data;
+	size_t size;
+	bool mapped;
+	std::string buffer;
+
+	bool map(const std::string& filename);
+	void unmap();
+};
+
+#endif
\ No newline at end of file
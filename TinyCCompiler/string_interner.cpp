@@ -0,0 +1,79 @@
+#include "string_interner.h"
+
+#include <cstring>
+
+static uint32_t hashName(std::string_view name) {
+	const char* data = name.data();
+	size_t size = name.size();
+	uint64_t hash = 0x9E3779B97F4A7C15ull ^ size;
+
+	// Eight bytes at a time, so long identifiers do not cost a step per character
+	while (size >= 8) {
+		uint64_t chunk;
+		std::memcpy(&chunk, data, 8);
+		hash = (hash ^ chunk) * 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 32;
+		data += 8;
+		size -= 8;
+	}
+
+	uint64_t tail = 0;
+	std::memcpy(&tail, data, size);
+	hash = (hash ^ tail) * 0xC4CEB9FE1A85EC53ull;
+	hash ^= hash >> 29;
+	return uint32_t(hash);
+}
+
+StringInterner::StringInterner() : currentBlock(nullptr), blockUsed(BLOCK_SIZE), slots(256, 0) {}
+
+Symbol StringInterner::intern(std::string_view name) {
+	uint32_t hash = hashName(name);
+	size_t mask = slots.size() - 1;
+
+	for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+		uint32_t slot = slots[i];
+		if (slot == 0) {
+			Symbol symbol = Symbol(names.size());
+			names.push_back(store(name));
+			hashes.push_back(hash);
+			slots[i] = symbol + 1;
+
+			if (names.size() * 2 > slots.size()) { grow(); }
+			return symbol;
+		}
+
+		Symbol symbol = slot - 1;
+		if (hashes[symbol] == hash && names[symbol] == name) { return symbol; }
+	}
+}
+
+std::string_view StringInterner::store(std::string_view name) {
+	if (name.size() > BLOCK_SIZE / 4) {
+		blocks.push_back(std::make_unique<char[]>(name.size()));
+		std::memcpy(blocks.back().get(), name.data(), name.size());
+		return std::string_view(blocks.back().get(), name.size());
+	}
+
+	if (BLOCK_SIZE - blockUsed < name.size()) {
+		blocks.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+		currentBlock = blocks.back().get();
+		blockUsed = 0;
+	}
+
+	char* destination = currentBlock + blockUsed;
+	std::memcpy(destination, name.data(), name.size());
+	blockUsed += name.size();
+	return std::string_view(destination, name.size());
+}
+
+void StringInterner::grow() {
+	std::vector<uint32_t> resized(slots.size() * 2, 0);
+	size_t mask = resized.size() - 1;
+
+	for (Symbol symbol = 0; symbol < names.size(); symbol++) {
+		size_t i = hashes[symbol] & mask;
+		while (resized[i] != 0) { i = (i + 1) & mask; }
+		resized[i] = symbol + 1;
+	}
+	slots.swap(resized);
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+typedef uint32_t Symbol;
+
+// Maps identifier names to dense 32-bit symbols. Names are copied once into an
+// arena and looked up through an open-addressing hash table, so two symbols are
+// equal exactly when their names are.
+class StringInterner {
+public:
+	StringInterner();
+	Symbol intern(std::string_view name);
+	std::string_view name(Symbol symbol) const { return names[symbol]; }
+	size_t size() const { return names.size(); }
+private:
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	// Arena for the name bytes; names longer than a quarter block get a block of their own
+	std::vector<std::unique_ptr<char[]>> blocks;
+	char* currentBlock;
+	size_t blockUsed;
+
+	std::vector<std::string_view> names;
+	std::vector<uint32_t> hashes;
+	std::vector<uint32_t> slots; // Symbol + 1, 0 marks an empty slot
+
+	std::string_view store(std::string_view name);
+	void grow();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "thread_pool.h"
+
+// Pool and queue index of the worker running on this thread
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+ThreadPool::ThreadPool(size_t threadCount) : nextQueue(0), queued(0), unfinished(0), stopping(false) {
+	if (threadCount == 0) { threadCount = 1; }
+	for (size_t i = 0; i < threadCount; i++) {
+		queues.emplace_back(new WorkerQueue());
+	}
+	for (size_t i = 0; i < threadCount; i++) {
+		workers.emplace_back([this, i] { work(i); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	taskAvailable.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+	size_t index;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		index = currentPool == this ? currentWorker : nextQueue++ % queues.size();
+		unfinished++;
+	}
+	{
+		std::lock_guard<std::mutex> lock(queues[index]->mutex);
+		queues[index]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued++;
+	}
+	taskAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	allDone.wait(lock, [this] { return unfinished == 0; });
+}
+
+bool ThreadPool::take(size_t index, std::function<void()>& task) {
+	{
+		WorkerQueue& own = *queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	for (size_t i = 1; i < queues.size(); i++) {
+		WorkerQueue& victim = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::work(size_t index) {
+	currentPool = this;
+	currentWorker = index;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			taskAvailable.wait(lock, [this] { return stopping || queued > 0; });
+			if (queued == 0) { return; }
+			queued--;
+		}
+
+		// The claim guarantees a queued task, but a scan can miss it while other workers take and submit
+		std::function<void()> task;
+		while (!take(index, task)) {
+			std::this_thread::yield();
+		}
+
+		task();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--unfinished == 0) { allDone.notify_all(); }
+	}
+}
\ No newline at end of file
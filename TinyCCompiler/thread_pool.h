@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads executing submitted tasks. Every worker owns a
+// queue: it takes its newest task first and steals the oldest task of another
+// worker when its own queue is empty, so uneven tasks keep all threads busy.
+class ThreadPool {
+public:
+	ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Tasks submitted by a worker go to its own queue, others are spread over all queues.
+	void submit(std::function<void()> task);
+	// Blocks until every submitted task has finished. Must not be called from a task.
+	void wait();
+	size_t size() const { return workers.size(); }
+
+	// Runs body(i) for every i in [0, count) on the pool and waits for all of them.
+	template <class TBody>
+	void parallelFor(size_t count, TBody body) {
+		for (size_t i = 0; i < count; i++) {
+			submit([&body, i] { body(i); });
+		}
+		wait();
+	}
+private:
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	size_t nextQueue;
+
+	// Guards the counters below; queued tasks are claimed here before being taken from a queue
+	std::mutex mutex;
+	std::condition_variable taskAvailable;
+	std::condition_variable allDone;
+	size_t queued;
+	size_t unfinished;
+	bool stopping;
+
+	void work(size_t index);
+	bool take(size_t index, std::function<void()>& task);
+};
+
+#endif
\ No newline at end of file
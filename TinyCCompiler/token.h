@@ -1,10 +1,11 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <cstdint>
 #include <string>
 #include <iostream>
 
-enum TokenType {
+enum TokenType : uint8_t {
 	// Conditional operator
 	IfOperator,
 	ElseOperator,
@@ -115,8 +116,6 @@ inline std::string tokenTypeToString(const TokenType& tokenType) {
 
 struct Token {
 	TokenType type;
-	std::string::const_iterator begin;
-	std::string::const_iterator end;
 	std::string lexeme;
 	int startPosition;
 	int line;
@@ -127,9 +126,7 @@ struct Token {
 	};
 
 	Token() {};
-	Token(TokenType _type, std::string::const_iterator _begin, std::string::const_iterator _end, std::string _lexeme, int _pos, int _line) : type(_type), begin(_begin), end(_end), lexeme(_lexeme), startPosition(_pos), line(_line) { };
-	Token(TokenType _type, std::string::const_iterator _begin, std::string::const_iterator _end, std::string _lexeme, int _val, int _pos, int _line) : type(_type), begin(_begin), end(_end), lexeme(_lexeme), intVal(_val), startPosition(_pos), line(_line) { };
-	Token(TokenType _type, std::string::const_iterator _begin, std::string::const_iterator _end, std::string _lexeme, float _val, int _pos, int _line) : type(_type), begin(_begin), end(_end), lexeme(_lexeme), floatVal(_val), startPosition(_pos), line(_line) { };
+	Token(TokenType _type, std::string _lexeme, int _pos, int _line) : type(_type), lexeme(_lexeme), startPosition(_pos), line(_line) { };
 
 	bool operator==(const Token& token) { return token.type == type && token.lexeme == lexeme; }
 	bool operator!=(const Token& token) { return token.type != type || token.lexeme != lexeme; }
@@ -139,4 +136,30 @@ struct Token {
 
 inline std::ostream& operator<<(std::ostream& out, const Token& token) { return out << tokenTypeToString(token.type) << " | " << token.lexeme; };
 
+// Token stored by value in token streams: a view into the source buffer
+// (offset + length) instead of an owned lexeme. Line and position are
+// recovered on demand by TokenStream.
+struct CompactToken {
+	uint32_t offset;
+	uint32_t length;
+	TokenType type;
+	bool outOfRange; // A literal its type can't hold; the value is 0 and the parser reports it
+
+	union {
+		int32_t intVal;
+		float floatVal;
+		uint32_t symbol; // Interned name of an identifier
+	};
+
+	CompactToken() : offset(0), length(0), type(TokenType::FAILED), outOfRange(false), intVal(0) {};
+	CompactToken(TokenType _type, uint32_t _offset, uint32_t _length) : offset(_offset), length(_length), type(_type), outOfRange(false), intVal(0) {};
+	CompactToken(TokenType _type, uint32_t _offset, uint32_t _length, int32_t _val) : offset(_offset), length(_length), type(_type), outOfRange(false), intVal(_val) {};
+	CompactToken(TokenType _type, uint32_t _offset, uint32_t _length, float _val) : offset(_offset), length(_length), type(_type), outOfRange(false), floatVal(_val) {};
+
+	uint32_t end() const { return offset + length; }
+	bool isUnaryOperator() const { return type == Negation || type == BitwiseComplement || type == LogicalNegation; }
+};
+
+static_assert(sizeof(CompactToken) <= 16, "CompactToken must stay within 16 bytes");
+
 #endif
\ No newline at end of file
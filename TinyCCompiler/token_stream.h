@@ -0,0 +1,134 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include "token.h"
+#include "simd_scan.h"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compact tokens read by index, together with the source buffer they point into.
+// The source must outlive the token source.
+class TokenSource {
+public:
+	TokenSource(std::string_view _source) : source(_source), lineStartsBuilt(false) {};
+	virtual ~TokenSource() {};
+
+	// Token at the given index. Past the end the End token is returned again.
+	virtual const CompactToken& get(size_t index) = 0;
+
+	std::string_view getSource() const { return source; }
+	std::string_view lexeme(const CompactToken& token) const { return source.substr(token.offset, token.length); }
+
+	int line(const CompactToken& token) const { return lineAt(token.offset); }
+	int position(const CompactToken& token) const { return positionAt(token.offset); }
+
+	int lineAt(uint32_t offset) const {
+		buildLineStarts();
+		return int(std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin()) - 1;
+	}
+
+	int positionAt(uint32_t offset) const {
+		return int(offset - lineStarts[lineAt(offset)]);
+	}
+
+	// Installs a line table computed elsewhere (offsets of the first character of every line).
+	void setLineStarts(std::vector<uint32_t> starts) {
+		lineStarts = std::move(starts);
+		lineStartsBuilt = true;
+	}
+
+	// Points the tokens at an edited copy of the source: the range [offset, offset + removedLength)
+	// of the old source was replaced by insertedLength bytes. Keeps the line table up to date.
+	void replaceSource(std::string_view newSource, uint32_t offset, uint32_t removedLength, uint32_t insertedLength) {
+		if (lineStartsBuilt) {
+			auto first = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+			auto last = std::upper_bound(first, lineStarts.end(), offset + removedLength);
+			size_t index = first - lineStarts.begin();
+			lineStarts.erase(first, last);
+
+			int64_t delta = int64_t(insertedLength) - int64_t(removedLength);
+			for (size_t i = index; i < lineStarts.size(); i++) { lineStarts[i] = uint32_t(lineStarts[i] + delta); }
+
+			std::vector<uint32_t> inserted;
+			for (size_t i = newSource.find('\n', offset); i < offset + insertedLength; i = newSource.find('\n', i + 1)) {
+				inserted.push_back(uint32_t(i + 1));
+			}
+			lineStarts.insert(lineStarts.begin() + index, inserted.begin(), inserted.end());
+		}
+		source = newSource;
+	}
+
+	// Materializes a full Token, e.g. for diagnostics.
+	Token expand(const CompactToken& token) const {
+		Token result(token.type, std::string(lexeme(token)), position(token), line(token));
+		result.intVal = token.intVal;
+		return result;
+	}
+
+private:
+	std::string_view source;
+
+	// Offsets of the first character of every line, built on first use.
+	mutable std::vector<uint32_t> lineStarts;
+	mutable bool lineStartsBuilt;
+
+	void buildLineStarts() const {
+		if (lineStartsBuilt) { return; }
+		lineStarts.reserve(scanKernels().countNewlines(source.data(), source.data() + source.size()) + 1);
+		lineStarts.push_back(0);
+		for (size_t i = source.find('\n'); i != std::string_view::npos; i = source.find('\n', i + 1)) {
+			lineStarts.push_back(uint32_t(i + 1));
+		}
+		lineStartsBuilt = true;
+	}
+};
+
+// Fully materialized token sequence. The last token must be End.
+class TokenStream : public TokenSource {
+public:
+	TokenStream(std::string_view _source) : TokenSource(_source) {};
+
+	const CompactToken& get(size_t index) override { return tokens[std::min(index, tokens.size() - 1)]; }
+
+	void push_back(const CompactToken& token) { tokens.push_back(token); }
+	void reserve(size_t count) { tokens.reserve(count); }
+	size_t size() const { return tokens.size(); }
+	const CompactToken& operator[](size_t i) const { return tokens[i]; }
+	const std::vector<CompactToken>& getTokens() const { return tokens; }
+	std::vector<CompactToken>& getTokens() { return tokens; }
+
+private:
+	std::vector<CompactToken> tokens;
+};
+
+// Pulls tokens from a lexer on demand and keeps only the last WINDOW of them,
+// so memory does not grow with the size of the input.
+template <class TLexer>
+class TokenWindow : public TokenSource {
+public:
+	static constexpr size_t WINDOW = 4;
+
+	TokenWindow(TLexer& _lexer, std::string_view _source) : TokenSource(_source), lexer(_lexer), fetched(0) {};
+
+	const CompactToken& get(size_t index) override {
+		while (fetched <= index) {
+			if (fetched > 0 && window[(fetched - 1) % WINDOW].type == TokenType::End) {
+				return window[(fetched - 1) % WINDOW];
+			}
+			window[fetched % WINDOW] = lexer.getNextToken();
+			fetched++;
+		}
+		return window[index % WINDOW];
+	}
+
+private:
+	TLexer& lexer;
+	std::array<CompactToken, WINDOW> window;
+	size_t fetched;
+};
+
+#endif
\ No newline at end of file
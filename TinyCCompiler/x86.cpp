@@ -0,0 +1,101 @@
+#include "x86.h"
+
+#include <string_view>
+
+static const std::string_view REGISTER_NAMES[] = {
+	"eax", "ebx", "ecx", "edx", "esi", "edi", "ebp", "esp",
+	"ax", "bx", "cx", "dx", "si", "di",
+	"al", "bl", "cl"
+};
+
+static const X86Register FULL_REGISTERS[] = {
+	X86Register::EAX, X86Register::EBX, X86Register::ECX, X86Register::EDX,
+	X86Register::ESI, X86Register::EDI, X86Register::EBP, X86Register::ESP,
+	X86Register::EAX, X86Register::EBX, X86Register::ECX, X86Register::EDX, X86Register::ESI, X86Register::EDI,
+	X86Register::EAX, X86Register::EBX, X86Register::ECX
+};
+
+static const std::string_view OP_NAMES[] = {
+	"", "", "mov", "movzx", "push", "pop", "add", "sub", "imul", "and", "or", "neg", "not", "cmp", "div",
+	"sete", "setne", "setl", "setge", "setg", "setle",
+	"jmp", "je", "jne", "jl", "jge", "jg", "jle", "ret"
+};
+
+static_assert(sizeof(REGISTER_NAMES) / sizeof(REGISTER_NAMES[0]) == size_t(X86Register::COUNT), "a register has no name");
+static_assert(sizeof(FULL_REGISTERS) / sizeof(FULL_REGISTERS[0]) == size_t(X86Register::COUNT), "a register has no full register");
+static_assert(sizeof(OP_NAMES) / sizeof(OP_NAMES[0]) == size_t(X86Op::COUNT), "an instruction has no name");
+
+X86Register fullRegister(X86Register reg) {
+	return FULL_REGISTERS[size_t(reg)];
+}
+
+X86Op negateCondition(X86Op op) {
+	switch (op) {
+	case X86Op::SETE: return X86Op::SETNE;
+	case X86Op::SETNE: return X86Op::SETE;
+	case X86Op::SETL: return X86Op::SETGE;
+	case X86Op::SETGE: return X86Op::SETL;
+	case X86Op::SETG: return X86Op::SETLE;
+	case X86Op::SETLE: return X86Op::SETG;
+	case X86Op::JE: return X86Op::JNE;
+	case X86Op::JNE: return X86Op::JE;
+	case X86Op::JL: return X86Op::JGE;
+	case X86Op::JGE: return X86Op::JL;
+	case X86Op::JG: return X86Op::JLE;
+	case X86Op::JLE: return X86Op::JG;
+	default: return op;
+	}
+}
+
+X86Op jumpOnCondition(X86Op set) {
+	// Both are listed in the order of their conditions
+	return X86Op(size_t(set) - size_t(X86Op::SETE) + size_t(X86Op::JE));
+}
+
+static void operandCode(const X86Operand& operand, const X86Operand& other, CodeSink& out) {
+	switch (operand.kind) {
+	case X86OperandKind::REGISTER:
+		out << REGISTER_NAMES[size_t(operand.reg)];
+		break;
+	case X86OperandKind::IMMEDIATE:
+		out << operand.value;
+		break;
+	case X86OperandKind::FRAME:
+		// Without a register operand the size has to be spelled out
+		if (other.kind != X86OperandKind::REGISTER) {
+			out << "dword ptr ";
+		}
+		out << "[ebp";
+		if (operand.value >= 0) {
+			out << '+';
+		}
+		out << operand.value << ']';
+		break;
+	case X86OperandKind::BLOCK:
+		out << "BLOCK_" << operand.value;
+		break;
+	case X86OperandKind::EDGE:
+		out << "EDGE_" << operand.value;
+		break;
+	case X86OperandKind::NONE:
+		break;
+	}
+}
+
+void printX86(const X86Code& code, CodeSink& out) {
+	for (const X86Instruction& instruction : code) {
+		if (instruction.op == X86Op::NOP) { continue; }
+		if (instruction.op == X86Op::LABEL) {
+			operandCode(instruction.operands[0], instruction.operands[1], out);
+			out << ":\n";
+			continue;
+		}
+
+		out << OP_NAMES[size_t(instruction.op)];
+		for (int i = 0; i < 2 && instruction.operands[i].kind != X86OperandKind::NONE; i++) {
+			out << (i == 0 ? " " : ", ");
+			operandCode(instruction.operands[i], instruction.operands[1 - i], out);
+		}
+		out << '\n';
+	}
+}
\ No newline at end of file
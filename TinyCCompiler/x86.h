@@ -0,0 +1,97 @@
+#ifndef X86_H
+#define X86_H
+
+#include "code_sink.h"
+
+#include <cstdint>
+#include <vector>
+
+enum class X86Register : uint8_t {
+	EAX, EBX, ECX, EDX, ESI, EDI, EBP, ESP,
+	AX, BX, CX, DX, SI, DI,  // Low words, for div
+	AL, BL, CL,              // Low bytes, for setcc
+
+	COUNT
+};
+
+// The 32-bit register a word or byte register is part of
+X86Register fullRegister(X86Register reg);
+
+enum class X86OperandKind : uint8_t {
+	NONE,
+	REGISTER,
+	IMMEDIATE,
+	FRAME,   // The dword at ebp + value
+	BLOCK,   // Label BLOCK_<value>
+	EDGE     // Label EDGE_<value>
+};
+
+struct X86Operand {
+	X86OperandKind kind;
+	X86Register reg;
+	int32_t value;
+
+	bool operator==(const X86Operand& other) const {
+		return kind == other.kind && (kind == X86OperandKind::REGISTER ? reg == other.reg : value == other.value);
+	}
+	bool operator!=(const X86Operand& other) const { return !(*this == other); }
+};
+
+inline X86Operand x86Register(X86Register reg) { return { X86OperandKind::REGISTER, reg, 0 }; }
+inline X86Operand x86Immediate(int32_t value) { return { X86OperandKind::IMMEDIATE, X86Register::COUNT, value }; }
+inline X86Operand x86Frame(int32_t offset) { return { X86OperandKind::FRAME, X86Register::COUNT, offset }; }
+inline X86Operand x86Block(uint32_t id) { return { X86OperandKind::BLOCK, X86Register::COUNT, int32_t(id) }; }
+inline X86Operand x86Edge(uint32_t id) { return { X86OperandKind::EDGE, X86Register::COUNT, int32_t(id) }; }
+
+enum class X86Op : uint8_t {
+	NOP,     // Deleted; not printed
+	LABEL,   // Defines the label in operands[0]
+	MOV,
+	MOVZX,
+	PUSH,
+	POP,
+	ADD,
+	SUB,
+	IMUL,
+	AND,
+	OR,
+	NEG,
+	NOT,
+	CMP,
+	DIV,
+	SETE,
+	SETNE,
+	SETL,
+	SETGE,
+	SETG,
+	SETLE,
+	JMP,
+	JE,
+	JNE,
+	JL,
+	JGE,
+	JG,
+	JLE,
+	RET,
+
+	COUNT
+};
+
+// An instruction with up to two operands, in Intel order: the destination first
+struct X86Instruction {
+	X86Op op;
+	X86Operand operands[2];
+};
+
+// The instructions of a function, in output order
+typedef std::vector<X86Instruction> X86Code;
+
+// The conditional jump or set instruction of the opposite condition
+X86Op negateCondition(X86Op op);
+// The conditional jump taken on the condition of a set instruction
+X86Op jumpOnCondition(X86Op set);
+
+// Prints the instructions as MASM, one per line
+void printX86(const X86Code& code, CodeSink& out);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "x86_peephole.h"
+
+#include <algorithm>
+#include <iterator>
+
+static bool isRegister(const X86Operand& operand, X86Register reg) {
+	return operand.kind == X86OperandKind::REGISTER && fullRegister(operand.reg) == reg;
+}
+
+// A 32-bit register other than ebp and esp, which the rules leave alone
+static bool isGeneralRegister(const X86Operand& operand) {
+	return operand.kind == X86OperandKind::REGISTER && fullRegister(operand.reg) == operand.reg
+		&& operand.reg != X86Register::EBP && operand.reg != X86Register::ESP;
+}
+
+static bool isControlFlow(X86Op op) {
+	return op == X86Op::LABEL || (op >= X86Op::JMP && op <= X86Op::RET);
+}
+
+static bool isConditionalJump(X86Op op) {
+	return op >= X86Op::JE && op <= X86Op::JLE;
+}
+
+static bool isSet(X86Op op) {
+	return op >= X86Op::SETE && op <= X86Op::SETLE;
+}
+
+// Whether all 32 bits of reg are written without being read
+static bool overwrites(const X86Instruction& instruction, X86Register reg) {
+	return (instruction.op == X86Op::MOV || instruction.op == X86Op::MOVZX || instruction.op == X86Op::POP)
+		&& instruction.operands[0].kind == X86OperandKind::REGISTER && instruction.operands[0].reg == reg
+		&& !isRegister(instruction.operands[1], reg);
+}
+
+// Writing part of a register counts as reading it, as the rest of it is kept
+static bool reads(const X86Instruction& instruction, X86Register reg) {
+	if (instruction.op == X86Op::DIV && (reg == X86Register::EAX || reg == X86Register::EDX)) {
+		return true;
+	}
+	return (isRegister(instruction.operands[0], reg) && !overwrites(instruction, reg)) || isRegister(instruction.operands[1], reg);
+}
+
+// Whether the value of reg after code[i] is never read. Labels and conditional jumps are
+// followed into the code after them.
+static bool deadAfter(const X86Code& code, size_t i, X86Register reg) {
+	for (size_t j = i + 1; j < code.size(); j++) {
+		const X86Instruction& instruction = code[j];
+		if (reads(instruction, reg)) { return false; }
+		if (overwrites(instruction, reg)) { return true; }
+		if (instruction.op == X86Op::JMP || instruction.op == X86Op::RET) {
+			return reg != X86Register::EBX;
+		}
+	}
+	return reg != X86Register::EBX;
+}
+
+// push a / pop b becomes mov b, a, also with a mov between them that leaves b alone
+static bool pushPopToMov(X86Code& code, size_t i) {
+	const X86Operand& pushed = code[i].operands[0];
+	if (!isGeneralRegister(pushed)) { return false; }
+
+	if (i + 1 < code.size() && code[i + 1].op == X86Op::POP && isGeneralRegister(code[i + 1].operands[0])) {
+		X86Operand popped = code[i + 1].operands[0];
+		code[i] = { X86Op::MOV, { popped, pushed } };
+		code[i + 1].op = X86Op::NOP;
+		if (popped == pushed) {
+			code[i].op = X86Op::NOP;
+		}
+		return true;
+	}
+
+	if (i + 2 < code.size() && code[i + 1].op == X86Op::MOV && code[i + 2].op == X86Op::POP && isGeneralRegister(code[i + 2].operands[0])) {
+		X86Operand popped = code[i + 2].operands[0];
+		if (reads(code[i + 1], popped.reg) || isRegister(code[i + 1].operands[0], popped.reg)) { return false; }
+		code[i + 2] = code[i + 1];
+		code[i + 1] = { X86Op::MOV, { popped, pushed } };
+		code[i].op = X86Op::NOP;
+		return true;
+	}
+	return false;
+}
+
+// mov r, x / ... / op y, r becomes op y, x when r isn't needed after it. The instructions
+// between have to leave r alone.
+static bool foldOperand(X86Code& code, size_t i, X86OperandKind kind) {
+	const X86Instruction& load = code[i];
+	if (!isGeneralRegister(load.operands[0]) || load.operands[1].kind != kind) { return false; }
+	X86Register reg = load.operands[0].reg;
+
+	for (size_t j = i + 1; j < code.size() && j <= i + 3; j++) {
+		X86Instruction& use = code[j];
+		if (isControlFlow(use.op)) { return false; }
+		if (!reads(use, reg) && !isRegister(use.operands[0], reg)) {
+			// A frame load can't move past a store
+			if (kind == X86OperandKind::FRAME && use.operands[0].kind == X86OperandKind::FRAME) { return false; }
+			continue;
+		}
+
+		bool folds = use.op == X86Op::MOV || use.op == X86Op::ADD || use.op == X86Op::SUB || use.op == X86Op::IMUL
+			|| use.op == X86Op::AND || use.op == X86Op::OR || use.op == X86Op::CMP;
+		if (!folds || use.operands[1] != load.operands[0] || isRegister(use.operands[0], reg)) { return false; }
+		// No memory to memory operands, and imul only multiplies into a register
+		bool registerTarget = use.operands[0].kind == X86OperandKind::REGISTER;
+		if ((kind == X86OperandKind::FRAME || use.op == X86Op::IMUL) && !registerTarget) { return false; }
+		if (!deadAfter(code, j, reg)) { return false; }
+
+		use.operands[1] = load.operands[1];
+		code[i].op = X86Op::NOP;
+		return true;
+	}
+	return false;
+}
+
+static bool foldImmediate(X86Code& code, size_t i) {
+	return foldOperand(code, i, X86OperandKind::IMMEDIATE);
+}
+
+static bool foldFrameLoad(X86Code& code, size_t i) {
+	return foldOperand(code, i, X86OperandKind::FRAME);
+}
+
+// mov [m], r / mov r, [m]: r still holds the value
+static bool storeAndReload(X86Code& code, size_t i) {
+	if (i + 1 >= code.size()) { return false; }
+	const X86Instruction& store = code[i];
+	const X86Instruction& load = code[i + 1];
+	if (store.operands[0].kind != X86OperandKind::FRAME || store.operands[1].kind != X86OperandKind::REGISTER) { return false; }
+	if (load.op != X86Op::MOV || load.operands[0] != store.operands[1] || load.operands[1] != store.operands[0]) { return false; }
+	code[i + 1].op = X86Op::NOP;
+	return true;
+}
+
+// The condition flag set by mov r, 0 / setcc r8 and tested by cmp r, 0 right after it
+static bool testsCondition(const X86Code& code, size_t i) {
+	if (i + 3 >= code.size() || !isGeneralRegister(code[i].operands[0])) { return false; }
+	X86Register reg = code[i].operands[0].reg;
+	return code[i].operands[1] == x86Immediate(0)
+		&& isSet(code[i + 1].op) && isRegister(code[i + 1].operands[0], reg)
+		&& code[i + 2].op == X86Op::CMP && isRegister(code[i + 2].operands[0], reg) && code[i + 2].operands[1] == x86Immediate(0);
+}
+
+// mov r, 0 / setcc r8 / cmp r, 0 / je l jumps on the first condition instead, when the flag
+// isn't needed after the branch
+static bool branchOnSet(X86Code& code, size_t i) {
+	if (!testsCondition(code, i)) { return false; }
+	X86Instruction& jump = code[i + 3];
+	if ((jump.op != X86Op::JE && jump.op != X86Op::JNE) || !deadAfter(code, i + 3, code[i].operands[0].reg)) { return false; }
+
+	X86Op condition = jumpOnCondition(code[i + 1].op);
+	jump.op = jump.op == X86Op::JNE ? condition : negateCondition(condition);
+	code[i].op = X86Op::NOP;
+	code[i + 1].op = X86Op::NOP;
+	code[i + 2].op = X86Op::NOP;
+	return true;
+}
+
+// mov r, 0 / setcc r8 / cmp r, 0 / mov r, 0 / sete r8 sets r on the opposite condition
+// straight away, and on the same one for setne. The flags are left as the first compare set
+// them, but the code generator compares again before every test.
+static bool setOnSet(X86Code& code, size_t i) {
+	if (!testsCondition(code, i) || i + 4 >= code.size()) { return false; }
+	const X86Instruction& zero = code[i + 3];
+	const X86Instruction& set = code[i + 4];
+	if (zero.op != X86Op::MOV || zero.operands[0] != code[i].operands[0] || zero.operands[1] != x86Immediate(0)) { return false; }
+	if ((set.op != X86Op::SETE && set.op != X86Op::SETNE) || set.operands[0] != code[i + 1].operands[0]) { return false; }
+
+	if (set.op == X86Op::SETE) {
+		code[i + 1].op = negateCondition(code[i + 1].op);
+	}
+	code[i + 2].op = X86Op::NOP;
+	code[i + 3].op = X86Op::NOP;
+	code[i + 4].op = X86Op::NOP;
+	return true;
+}
+
+// jcc a / jmp b / a: becomes jncc b / a:
+static bool invertBranch(X86Code& code, size_t i) {
+	if (i + 2 >= code.size() || !isConditionalJump(code[i].op)) { return false; }
+	if (code[i + 1].op != X86Op::JMP || code[i + 2].op != X86Op::LABEL || code[i + 2].operands[0] != code[i].operands[0]) { return false; }
+	code[i] = { negateCondition(code[i].op), { code[i + 1].operands[0] } };
+	code[i + 1].op = X86Op::NOP;
+	return true;
+}
+
+// Bytes the instruction moves esp up by, when it only adjusts the stack
+static bool stackAdjustment(const X86Code& code, size_t i, int32_t& bytes) {
+	const X86Instruction& instruction = code[i];
+	if (instruction.op == X86Op::POP) {
+		bytes = 4;
+		return isGeneralRegister(instruction.operands[0]) && deadAfter(code, i, instruction.operands[0].reg);
+	}
+	if ((instruction.op != X86Op::ADD && instruction.op != X86Op::SUB) || !isRegister(instruction.operands[0], X86Register::ESP)
+		|| instruction.operands[1].kind != X86OperandKind::IMMEDIATE) {
+		return false;
+	}
+	bytes = instruction.op == X86Op::ADD ? instruction.operands[1].value : -instruction.operands[1].value;
+	return true;
+}
+
+// Two stack adjustments in a row, pops into registers nothing reads included, become one
+static bool mergeStackAdjustments(X86Code& code, size_t i) {
+	int32_t first, second;
+	if (i + 1 >= code.size() || !stackAdjustment(code, i, first) || !stackAdjustment(code, i + 1, second)) { return false; }
+	int32_t bytes = first + second;
+	code[i] = { bytes >= 0 ? X86Op::ADD : X86Op::SUB, { x86Register(X86Register::ESP), x86Immediate(bytes >= 0 ? bytes : -bytes) } };
+	code[i + 1].op = X86Op::NOP;
+	if (bytes == 0) {
+		code[i].op = X86Op::NOP;
+	}
+	return true;
+}
+
+// A rule looks at the instructions from code[i] on and rewrites them in place when it
+// applies. Instructions it deletes become NOPs, which are removed after every sweep.
+struct PeepholeRule {
+	const char* name;
+	uint64_t first;   // The instructions a match can start with, as bits
+	bool (*apply)(X86Code& code, size_t i);
+};
+
+static constexpr uint64_t bit(X86Op op) { return uint64_t(1) << size_t(op); }
+
+static_assert(size_t(X86Op::COUNT) <= 64, "instructions don't fit the rule masks");
+
+static const PeepholeRule RULES[] = {
+	{ "push/pop to mov", bit(X86Op::PUSH), pushPopToMov },
+	{ "fold immediate", bit(X86Op::MOV), foldImmediate },
+	{ "fold frame load", bit(X86Op::MOV), foldFrameLoad },
+	{ "store and reload", bit(X86Op::MOV), storeAndReload },
+	{ "branch on setcc", bit(X86Op::MOV), branchOnSet },
+	{ "setcc of setcc", bit(X86Op::MOV), setOnSet },
+	{ "invert branch", bit(X86Op::JE) | bit(X86Op::JNE) | bit(X86Op::JL) | bit(X86Op::JGE) | bit(X86Op::JG) | bit(X86Op::JLE), invertBranch },
+	{ "merge stack adjustments", bit(X86Op::ADD) | bit(X86Op::SUB) | bit(X86Op::POP), mergeStackAdjustments }
+};
+
+PeepholeStats::PeepholeStats() : hits(std::size(RULES), 0) {}
+
+void PeepholeStats::append(const PeepholeStats& other) {
+	for (size_t i = 0; i < hits.size(); i++) {
+		hits[i] += other.hits[i];
+	}
+}
+
+void PeepholeStats::print(std::ostream& out) const {
+	out << "Peephole rule hits:\n";
+	for (size_t i = 0; i < hits.size(); i++) {
+		out << "  " << RULES[i].name << ": " << hits[i] << '\n';
+	}
+	out.flush();
+}
+
+void optimizePeephole(X86Code& code, PeepholeStats& stats) {
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (size_t i = 0; i < code.size(); i++) {
+			for (size_t rule = 0; rule < std::size(RULES); rule++) {
+				if (!(RULES[rule].first & bit(code[i].op))) { continue; }
+				if (RULES[rule].apply(code, i)) {
+					stats.hit(rule);
+					changed = true;
+					break;
+				}
+			}
+		}
+		code.erase(std::remove_if(code.begin(), code.end(), [](const X86Instruction& instruction) {
+			return instruction.op == X86Op::NOP;
+		}), code.end());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef X86_PEEPHOLE_H
+#define X86_PEEPHOLE_H
+
+#include "x86.h"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// How often each peephole rule applied, summed over the functions of a compilation
+class PeepholeStats {
+public:
+	PeepholeStats();
+
+	void hit(size_t rule) { hits[rule]++; }
+	void append(const PeepholeStats& other);
+	// One line per rule, in the order of the rule table
+	void print(std::ostream& out) const;
+private:
+	std::vector<uint64_t> hits;
+};
+
+// Rewrites short windows of a function's instructions into cheaper equivalents by the rules of
+// a table, sweeping until no rule applies. The code is taken to follow the conventions of the
+// code generator: at a jmp or ret only ebx can hold a value that is still needed, and a
+// conditional jump goes to code that sets every register before reading it.
+void optimizePeephole(X86Code& code, PeepholeStats& stats);
+
+#endif
\ No newline at end of file